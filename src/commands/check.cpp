@@ -11,16 +11,15 @@ namespace {
 struct Options
 {
 	std::string cnfFile, solFile;
+	int threads = 1;
 };
 
 void run_check_command(const Options &opt)
 {
-	auto [clauses, varCount] = parseCnf(opt.cnfFile);
+	// the CNF is only streamed through, never stored
+	auto sol = parseAssignment(opt.solFile);
 
-	auto sol = Assignment(varCount);
-	parseAssignment(opt.solFile, sol);
-
-	if (sol.satisfied(clauses))
+	if (checkSolution(opt.cnfFile, sol, opt.threads))
 	{
 		fmt::print("c solution checked\n");
 		std::exit(0);
@@ -42,5 +41,8 @@ void setup_check_command(CLI::App &app)
 	    ->type_name("<filename>");
 	app.add_option("output", opt->solFile, "output solution in dimacs format")
 	    ->type_name("<filename>");
+	app.add_option("--threads", opt->threads,
+	               "number of threads for checking large files "
+	               "(default=1, all cores=0)");
 	app.callback([opt]() { run_check_command(*opt); });
 }
@@ -0,0 +1,59 @@
+#include "CLI/CLI.hpp"
+#include "fmt/format.h"
+#include "sat/dimacs.h"
+#include "sat/proof_check.h"
+#include "util/logging.h"
+
+using namespace dawn;
+
+namespace {
+
+struct Options
+{
+	std::string cnfFile, proofFile;
+	std::string format = "drat";
+};
+
+void run_check_proof_command(const Options &opt)
+{
+	auto log = util::Logger("check-proof");
+
+	// original clauses in file order (LRAT IDs depend on it)
+	auto clauses = parseCnf(opt.cnfFile).first;
+
+	auto result = opt.format == "lrat"
+	                  ? check_lrat_proof(clauses, opt.proofFile)
+	                  : check_drat_proof(clauses, opt.proofFile);
+	log.info("{} lemmas, {} checked, {} RAT, {} deletions ({} ignored)",
+	         result.lemmas, result.checked, result.rat, result.deletions,
+	         result.ignored);
+
+	if (result.valid)
+	{
+		fmt::print("s VERIFIED\n");
+		std::exit(0);
+	}
+	else
+	{
+		fmt::print("c {}\n", result.message);
+		fmt::print("s NOT VERIFIED\n");
+		std::exit(1);
+	}
+}
+} // namespace
+
+void setup_check_proof_command(CLI::App &app)
+{
+	auto opt = std::make_shared<Options>();
+
+	app.add_option("input", opt->cnfFile, "input CNF in dimacs format")
+	    ->type_name("<filename>")
+	    ->required();
+	app.add_option("proof", opt->proofFile,
+	               "proof of unsatisfiability (text or binary)")
+	    ->type_name("<filename>")
+	    ->required();
+	app.add_option("--format", opt->format, "proof format (drat or lrat)")
+	    ->check(CLI::IsMember({"drat", "lrat"}));
+	app.callback([opt]() { run_check_proof_command(*opt); });
+}
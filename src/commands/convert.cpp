@@ -0,0 +1,54 @@
+#include "CLI/CLI.hpp"
+#include "fmt/format.h"
+#include "sat/binary_cnf.h"
+#include "sat/cnf.h"
+#include "sat/dimacs.h"
+#include "sat/solver.h"
+
+using namespace dawn;
+
+namespace {
+
+struct Options
+{
+	std::string input, output;
+	bool preprocess = false;
+	SolverConfig config;
+};
+
+void run_convert_command(Options opt)
+{
+	// converting an already simplified file has to keep its reconstruction
+	Cnf sat;
+	bool simplified = parseCnf(opt.input, sat, opt.config.threads);
+
+	if (opt.preprocess)
+	{
+		cleanup(sat, opt.config.threads);
+		preprocess(sat, opt.config);
+		simplified = true;
+	}
+
+	write_binary_cnf(opt.output, sat, simplified);
+}
+
+} // namespace
+
+void setup_convert_command(CLI::App &app)
+{
+	auto opt = std::make_shared<Options>();
+	app.add_option("input", opt->input,
+	               "input CNF (DIMACS, possibly compressed)")
+	    ->type_name("<filename>")
+	    ->required();
+	app.add_option("output", opt->output, "output file in binary format")
+	    ->type_name("<filename>")
+	    ->required();
+	app.add_flag("--preprocess", opt->preprocess,
+	             "run the preprocessing of 'solve' and store the simplified "
+	             "formula (including reconstruction information)");
+	app.add_option("--threads", opt->config.threads,
+	               "number of threads for parsing and preprocessing "
+	               "(default=1, all cores=0)");
+	app.callback([opt]() { run_convert_command(*opt); });
+}
@@ -0,0 +1,101 @@
+#include "CLI/CLI.hpp"
+#include "fmt/format.h"
+#include "sat/approxmc.h"
+#include "sat/cnf.h"
+#include "sat/dimacs.h"
+#include "util/logging.h"
+#include <algorithm>
+#include <csignal>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace dawn;
+
+namespace {
+std::stop_source global_ssource;
+extern "C" void countInterruptHandler(int)
+{
+	global_ssource.request_stop();
+	signal(SIGINT, SIG_DFL);
+}
+
+struct Options
+{
+	std::string input;
+	std::vector<int> projection; // DIMACS variables
+	int64_t seed = 0;
+	int timeout = 0;
+	ApproxMCConfig mc;
+	SolverConfig config;
+};
+
+void run_count_command(Options opt)
+{
+	util::Logger::set_sink(
+	    [](std::string_view msg) { fmt::print("c {}\n", msg); });
+	Cnf sat;
+	parseCnf(opt.input, sat);
+
+	std::vector<int> projection;
+	for (int v : opt.projection)
+	{
+		if (v < 1 || v > sat.var_count())
+			throw std::runtime_error(
+			    fmt::format("projection variable {} out of range", v));
+		projection.push_back(v - 1);
+	}
+	std::ranges::sort(projection);
+	projection.erase(std::unique(projection.begin(), projection.end()),
+	                 projection.end());
+
+	opt.config.seed = opt.seed;
+	opt.mc.seed = opt.seed;
+	std::signal(SIGINT, &countInterruptHandler);
+	if (opt.timeout > 0)
+	{
+		std::signal(SIGALRM, &countInterruptHandler);
+		alarm(opt.timeout);
+	}
+
+	auto count = approx_count(std::move(sat), projection, opt.config, opt.mc,
+	                          global_ssource.get_token());
+	util::Logger::print_summary();
+	if (!count)
+	{
+		fmt::print("s UNKNOWN\n");
+		std::exit(30);
+	}
+	if (count->exact)
+		fmt::print("c exact count\n");
+	else
+		fmt::print("c estimate = {} * 2^{}\n", count->cell_count,
+		           count->hash_count);
+	fmt::print("s mc {}\n", count->to_string());
+}
+
+} // namespace
+
+void setup_count_command(CLI::App &app)
+{
+	auto opt = std::make_shared<Options>();
+	app.add_option("input", opt->input, "input CNF in dimacs format")
+	    ->type_name("<filename>");
+	app.add_option("--project", opt->projection,
+	               "comma-separated variables to count solutions on (default: "
+	               "all variables)")
+	    ->delimiter(',');
+	app.add_option("--epsilon", opt->mc.epsilon,
+	               "tolerance, i.e., the result is within a factor of "
+	               "(1+epsilon) of the true count");
+	app.add_option("--delta", opt->mc.delta,
+	               "confidence, i.e., the result is within the tolerance with "
+	               "probability at least 1-delta");
+	app.add_option("--seed", opt->seed,
+	               "seed for random number generator (default=0)");
+	app.add_option("--max-time", opt->timeout,
+	               "stop counting after (approximately) this time (seconds)");
+	app.callback([opt]() { run_count_command(*opt); });
+}
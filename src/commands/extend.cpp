@@ -0,0 +1,46 @@
+#include "CLI/CLI.hpp"
+#include "fmt/format.h"
+#include "sat/binary_cnf.h"
+#include "sat/dimacs.h"
+#include "sat/reconstruction.h"
+
+using namespace dawn;
+
+namespace {
+
+struct Options
+{
+	std::string recon_file, input, output;
+};
+
+void run_extend_command(Options const &opt)
+{
+	auto recon = read_reconstruction(opt.recon_file);
+
+	// solution of the simplified formula
+	auto inner = Assignment(recon.inner_var_count());
+	parseAssignment(opt.input, inner);
+
+	// solution of the original formula
+	auto sol = recon(inner);
+
+	writeSolution(opt.output, sol);
+}
+} // namespace
+
+void setup_extend_command(CLI::App &app)
+{
+	auto opt = std::make_shared<Options>();
+
+	app.add_option("recon", opt->recon_file,
+	               "reconstruction information written by 'simplify'")
+	    ->type_name("<filename>")
+	    ->required();
+	app.add_option("input", opt->input,
+	               "solution of the simplified formula (default=stdin)")
+	    ->type_name("<filename>");
+	app.add_option("output", opt->output,
+	               "output solution of the original formula (default=stdout)")
+	    ->type_name("<filename>");
+	app.callback([opt]() { run_extend_command(*opt); });
+}
@@ -1,5 +1,7 @@
 #include "CLI/CLI.hpp"
 #include "fmt/format.h"
+#include "fmt/os.h"
+#include "sat/binary_cnf.h"
 #include "sat/cnf.h"
 #include "sat/dimacs.h"
 #include "sat/elimination.h"
@@ -12,13 +14,13 @@ namespace {
 
 struct Options
 {
-	std::string input;
+	std::string input, output, recon_file;
 };
 
 void run_simplify_command(Options opt)
 {
-	auto [clauses, varCount] = parseCnf(opt.input);
-	auto sat = Cnf(varCount, std::move(clauses));
+	Cnf sat;
+	parseCnf(opt.input, sat);
 
 	print_stats(sat);
 
@@ -42,6 +44,16 @@ void run_simplify_command(Options opt)
 		cleanup(sat);
 	}
 	print_stats(sat);
+
+	// Simplified formula in plain DIMACS, so that any solver can be used on
+	// it. Solutions are mapped back to the original using 'dawn extend'.
+	if (!opt.output.empty())
+	{
+		fmt::output_file(opt.output).print("{}", sat);
+		if (opt.recon_file.empty())
+			opt.recon_file = opt.output + ".recon";
+		write_reconstruction(opt.recon_file, sat.reconstruction());
+	}
 }
 
 } // namespace
@@ -50,5 +62,11 @@ void setup_simplify_command(CLI::App &app)
 {
 	auto opt = std::make_shared<Options>();
 	app.add_option("input", opt->input, "input file");
+	app.add_option("output", opt->output, "output simplified CNF")
+	    ->type_name("<filename>");
+	app.add_option("--recon", opt->recon_file,
+	               "output reconstruction information, needed to map solutions "
+	               "back to the original formula (default=<output>.recon)")
+	    ->type_name("<filename>");
 	app.callback([opt]() { run_simplify_command(*opt); });
 }
\ No newline at end of file
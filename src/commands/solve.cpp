@@ -1,9 +1,13 @@
 #include "CLI/CLI.hpp"
 #include "sat/cnf.h"
 #include "sat/dimacs.h"
+#include "sat/incremental.h"
+#include "sat/proof.h"
 #include "sat/solver.h"
 #include "sat/stats.h"
 #include <csignal>
+#include <filesystem>
+#include <optional>
 #include <stop_token>
 #include <string>
 
@@ -24,22 +28,162 @@ struct Options
 {
 	std::string cnfFile, solFile;
 	std::string binary_solution_file;
+	std::string proof_file, proof_format = "drat";
+	bool proof_text = false;
 	bool shuffle = false;
 	int64_t seed = 0;
 	int timeout = 0;
 	bool watch_stats = false;
+	std::optional<int64_t> enumerate; // max number of solutions, 0 = all
+	std::vector<int> projection;      // DIMACS variables
 	SolverConfig config;
 };
 
+// Enumerate solutions, printing each of them as a 'v' line (only the
+// projection variables, if given). Returns 10 if there was at least one
+// solution, otherwise 20 (or 30 if stopped before finding any).
+int run_enumeration(Options const &opt, Cnf sat,
+                    std::optional<ClauseStorage> originalClauses)
+{
+	int varCount = sat.reconstruction().orig_var_count();
+	std::vector<int> projection;
+	for (int v : opt.projection)
+	{
+		if (v < 1 || v > varCount)
+			throw std::runtime_error(
+			    fmt::format("projection variable {} out of range", v));
+		projection.push_back(v - 1);
+	}
+	std::vector<int> printed = projection;
+	if (printed.empty())
+		for (int i = 0; i < varCount; ++i)
+			printed.push_back(i);
+
+	// every solution is checked, so keep the original clauses around
+	if (!originalClauses)
+		originalClauses = parseCnf(opt.cnfFile, opt.config.threads).first;
+
+	std::optional<fmt::ostream> file;
+	if (opt.solFile != "")
+		file.emplace(fmt::output_file(opt.solFile));
+
+	auto solver = IncrementalSolver(std::move(sat), opt.config);
+	int64_t count = 0;
+	std::string line;
+	int result = solver.enumerate(
+	    projection,
+	    [&] {
+		    auto sol = Assignment(varCount);
+		    for (int i = 0; i < varCount; ++i)
+			    sol.set(Lit(i, solver.value(Lit(i, false)) == lfalse));
+		    if (!sol.satisfied(*originalClauses))
+		    {
+			    std::cout << "s SOLUTION CHECK FAILED" << std::endl;
+			    std::exit(-1);
+		    }
+
+		    // status line goes first, as in a regular solution
+		    if (count == 0)
+		    {
+			    fmt::print("s SATISFIABLE\n");
+			    if (file)
+				    file->print("s SATISFIABLE\n");
+		    }
+
+		    line = "v";
+		    for (int i : printed)
+			    line += fmt::format(" {}",
+			                        Lit(i, !sol[Lit(i, false)]).toDimacs());
+		    line += " 0\n";
+		    fmt::print("{}", line);
+		    if (file)
+			    file->print("{}", line);
+
+		    count += 1;
+		    return *opt.enumerate == 0 || count < *opt.enumerate;
+	    },
+	    global_ssource.get_token());
+
+	fmt::print("c found {} solutions{}\n", count,
+	           result == 20 ? " (all of them)" : "");
+	if (count == 0)
+	{
+		auto status = result == 20 ? "s UNSATISFIABLE\n" : "s UNKNOWN\n";
+		fmt::print("{}", status);
+		if (file)
+			file->print("{}", status);
+	}
+	return count > 0 ? 10 : result;
+}
+
 void run_solve_command(Options opt)
 {
 	util::Logger::set_sink(
 	    [](std::string_view msg) { fmt::print("c {}\n", msg); });
-	// read CNF from file or stdin
-	auto [originalClauses, varCount] = parseCnf(opt.cnfFile);
-	auto sat = Cnf(varCount, originalClauses); // clauses are copied here!
+	// read CNF from file or stdin. Original clauses are only kept for checking
+	// the solution when reading from stdin or a pipe, which can not be read
+	// twice. Regular files are simply read again. A 'preprocessed' file is a
+	// cached formula which is already simplified. Solutions are mapped back
+	// to the original formula, but can not be checked against it.
+	Cnf sat;
+	std::optional<ClauseStorage> originalClauses;
+	bool preprocessed = false;
+	if (std::error_code ec;
+	    !std::filesystem::is_regular_file(opt.cnfFile, ec))
+	{
+		auto [clauses, varCount] = parseCnf(opt.cnfFile, opt.config.threads);
+		sat = Cnf(varCount, clauses); // clauses are copied here!
+		originalClauses = std::move(clauses);
+	}
+	else
+		preprocessed = parseCnf(opt.cnfFile, sat, opt.config.threads);
+	if (preprocessed)
+		opt.config.preprocess = false;
+
+	if (opt.enumerate)
+	{
+		if (preprocessed)
+			throw std::runtime_error(
+			    "can not enumerate solutions of a preprocessed input");
+		if (!opt.proof_file.empty())
+			throw std::runtime_error(
+			    "can not write a proof while enumerating solutions");
+		if (opt.config.sls)
+			throw std::runtime_error(
+			    "local search can not enumerate solutions");
+		if (opt.binary_solution_file != "")
+			throw std::runtime_error(
+			    "binary solution output is not supported when enumerating");
+	}
+	else if (!opt.projection.empty())
+		throw std::runtime_error("projection only applies to --enumerate");
+
+	// DRAT/LRAT proof of unsatisfiability. Parallel pre-/inprocessing merges
+	// results out of order, so it is turned off in order to keep the proof
+	// valid. LRAT refers to the original clauses by index, so it needs them in
+	// order of the input file.
+	std::optional<ProofWriter> proof;
+	if (!opt.proof_file.empty())
+	{
+		if (preprocessed)
+			throw std::runtime_error(
+			    "can not write a proof for a preprocessed input");
+		if (opt.proof_format == "lrat" && originalClauses)
+			proof.emplace(opt.proof_file, *originalClauses, !opt.proof_text);
+		else if (opt.proof_format == "lrat")
+			proof.emplace(opt.proof_file,
+			              parseCnf(opt.cnfFile, opt.config.threads).first,
+			              !opt.proof_text);
+		else
+			proof.emplace(opt.proof_file, !opt.proof_text);
+		sat.proof = &*proof;
+		opt.config.threads = 1;
+	}
+
+	[[maybe_unused]] int varCount = sat.reconstruction().orig_var_count();
 	if (opt.seed == -1)
 		opt.seed = std::random_device()();
+	opt.config.seed = opt.seed;
 	auto rng = util::xoshiro256(opt.seed);
 	if (opt.shuffle)
 		shuffle_variables(sat, rng);
@@ -51,73 +195,85 @@ void run_solve_command(Options opt)
 		alarm(opt.timeout);
 	}
 
-	// solve
-	int result = 10;
-	while (result == 10)
+	// enumerate solutions instead of just finding one
+	if (opt.enumerate)
 	{
-		Assignment sol;
+		int result =
+		    run_enumeration(opt, std::move(sat), std::move(originalClauses));
+		util::Logger::print_summary();
+		std::exit(result);
+	}
+
+	// solve
+	int result;
+	Assignment sol;
+	if (opt.config.sls)
+		result = solve_sls(sat, sol, opt.config, global_ssource.get_token());
+	else
 		result = solve(sat, sol, opt.config, global_ssource.get_token());
 
-		// print to stdout
-		if (result == 10)
+	// print to stdout
+	if (result == 10)
+	{
+		fmt::print("s SATISFIABLE\n");
+		assert(sol.var_count() == varCount);
+		if (preprocessed)
+			std::cout << "c solution not checked (preprocessed input)"
+			          << std::endl;
+		else if (originalClauses ? sol.satisfied(*originalClauses)
+		                         : checkSolution(opt.cnfFile, sol,
+		                                         opt.config.threads))
+			std::cout << "s solution checked" << std::endl;
+		else
 		{
-			fmt::print("s SATISFIABLE\n");
-			assert(sol.var_count() == varCount);
-			if (sol.satisfied(originalClauses))
-				std::cout << "s solution checked" << std::endl;
-			else
-			{
-				std::cout << "s SOLUTION CHECK FAILED" << std::endl;
-				std::exit(-1);
-			}
+			std::cout << "s SOLUTION CHECK FAILED" << std::endl;
+			std::exit(-1);
 		}
-		else if (result == 20)
-			fmt::print("s UNSATISFIABLE\n");
+	}
+	else if (result == 20)
+		fmt::print("s UNSATISFIABLE\n");
+	else if (result == 30)
+		fmt::print("s UNKNOWN\n");
+	else
+		assert(false);
+
+	// print to file
+	if (opt.solFile != "" && result == 10)
+		writeSolution(opt.solFile, sol);
+	else if (opt.solFile != "")
+	{
+		auto file = fmt::output_file(opt.solFile);
+		if (result == 20)
+			file.print("s UNSATISFIABLE\n");
 		else if (result == 30)
-			fmt::print("s UNKNOWN\n");
+			file.print("s UNKNOWN\n");
 		else
 			assert(false);
+	}
 
-		// print to file
-		if (opt.solFile != "")
-		{
-			auto file = fmt::output_file(opt.solFile);
-			if (result == 10)
-			{
-				file.print("s SATISFIABLE\n");
-				file.print("v {} 0\n", sol);
-			}
-			else if (result == 20)
-				file.print("s UNSATISFIABLE\n");
-			else if (result == 30)
-				file.print("s UNKNOWN\n");
-			else
-				assert(false);
-		}
-
-		// print to binary file
-		if (opt.binary_solution_file != "")
-		{
-			// write
-			auto buf = util::bit_vector(sol.var_count());
-			for (int i = 0; i < sol.var_count(); ++i)
-				buf[i] = sol.satisfied(Lit(i, false));
-
-			// write buf to file
+	// print to binary file
+	if (opt.binary_solution_file != "")
+	{
+		// write
+		auto buf = util::bit_vector(sol.var_count());
+		for (int i = 0; i < sol.var_count(); ++i)
+			buf[i] = sol.satisfied(Lit(i, false));
 
-			std::ofstream f(opt.binary_solution_file, std::ios::binary);
-			if (!f)
-				throw std::runtime_error(
-				    "Could not open binary solution file: " +
-				    opt.binary_solution_file);
+		// write buf to file
 
-			f.write((const char *)buf.data(), (buf.size() + 7) / 8);
-			f.close();
-		}
+		std::ofstream f(opt.binary_solution_file, std::ios::binary);
+		if (!f)
+			throw std::runtime_error("Could not open binary solution file: " +
+			                         opt.binary_solution_file);
 
-		break;
+		f.write((const char *)buf.data(), (buf.size() + 7) / 8);
+		f.close();
 	}
 
+	// NOTE: 'std::exit' does not run destructors
+	if (proof)
+		proof->flush();
+
 	// statistics
 	util::Logger::print_summary();
 	std::exit(result);
@@ -136,6 +292,15 @@ void setup_solve_command(CLI::App &app)
 	app.add_option("--binary-solution", opt->binary_solution_file,
 	               "output solution as plain binary file")
 	    ->type_name("<filename>");
+	app.add_option("--proof", opt->proof_file,
+	               "write a DRAT/LRAT proof in case of UNSAT (turns off "
+	               "multi-threaded inprocessing)")
+	    ->type_name("<filename>");
+	app.add_option("--proof-format", opt->proof_format,
+	               "drat (default) or lrat (with hints, faster to check)")
+	    ->check(CLI::IsMember({"drat", "lrat"}));
+	app.add_flag("--proof-text", opt->proof_text,
+	             "write the proof in text format instead of binary");
 
 	// general options
 	auto g = "Options";
@@ -152,6 +317,23 @@ void setup_solve_command(CLI::App &app)
 	app.add_flag("--shuffle", opt->shuffle,
 	             "shuffle the variables and their polarities before solving")
 	    ->group(g);
+	app.add_flag("--sls", opt->config.sls,
+	             "only run stochastic local search (ProbSAT), which can find "
+	             "solutions but not prove unsatisfiability")
+	    ->group(g);
+	app.add_option("--max-flips", opt->config.max_flips,
+	               "stop local search after this many flips")
+	    ->group(g);
+	app.add_option("--enumerate", opt->enumerate,
+	               "enumerate up to this many solutions (0=all) instead of "
+	               "finding one. Each is printed as a 'v' line")
+	    ->group(g);
+	app.add_option("--project", opt->projection,
+	               "comma-separated variables to project solutions onto when "
+	               "enumerating, i.e., only solutions differing on those "
+	               "count as distinct")
+	    ->delimiter(',')
+	    ->group(g);
 
 	// options for the CDCL search
 	g = "Clause Learning";
@@ -163,6 +345,16 @@ void setup_solve_command(CLI::App &app)
 	               "branch on dominating literal instead of chosen one itself"
 	               "0=off, 1=matching polarity only, 2=always")
 	    ->group(g);
+	app.add_option("--heuristic", opt->config.heuristic,
+	               "decision heuristic: vsids (default), vmtf, lrb")
+	    ->transform(CLI::CheckedTransformer(std::map<std::string, Heuristic>{
+	        {"vsids", Heuristic::vsids},
+	        {"vmtf", Heuristic::vmtf},
+	        {"lrb", Heuristic::lrb}}))
+	    ->group(g);
+	app.add_option("--decay", opt->config.decay,
+	               "activity decay factor per conflict (default=1.05)")
+	    ->group(g);
 
 	// clause cleaning
 	g = "Clause Cleaning";
@@ -175,19 +367,79 @@ void setup_solve_command(CLI::App &app)
 	// restarts
 	g = "Restarts";
 	app.add_option("--restart-type", opt->config.restart_type,
-	               "constant, linear, geometric, luby")
+	               "constant, linear, geometric, luby, dynamic")
 	    ->transform(CLI::CheckedTransformer(std::map<std::string, RestartType>{
 	        {"constant", RestartType::constant},
 	        {"linear", RestartType::linear},
 	        {"geometric", RestartType::geometric},
-	        {"luby", RestartType::luby}}))
+	        {"luby", RestartType::luby},
+	        {"dynamic", RestartType::dynamic}}))
 	    ->group(g);
 	app.add_option("--restart-base", opt->config.restart_base,
-	               "base multiplier (default=100)")
+	               "base multiplier, or minimal number of conflicts between "
+	               "dynamic restarts (default=100)")
 	    ->group(g);
 	app.add_option("--restart-mult", opt->config.restart_mult,
 	               "multiplier for geometric restart (default=1.1)")
 	    ->group(g);
+	app.add_option("--restart-margin", opt->config.restart_margin,
+	               "dynamic restart when recent LBD exceeds average LBD by "
+	               "this factor (default=1.25)")
+	    ->group(g);
+	app.add_option("--restart-block", opt->config.restart_block,
+	               "block dynamic restart when trail exceeds average trail "
+	               "size by this factor (default=1.4)")
+	    ->group(g);
+
+	// search modes
+	g = "Search Modes";
+	app.add_flag("--modes", opt->config.modes,
+	             "alternate between focused mode (dynamic restarts, vmtf) "
+	             "and stable mode (luby restarts, slowly decaying vsids). "
+	             "Overrides --restart-type, --heuristic and --decay")
+	    ->group(g);
+	app.add_option("--mode-length", opt->config.mode_length,
+	               "conflicts in the first (focused) phase (default=1000)")
+	    ->group(g);
+	app.add_option("--mode-mult", opt->config.mode_mult,
+	               "growth factor of phase lengths (default=2)")
+	    ->group(g);
+	app.add_option("--focused-heuristic", opt->config.focused_heuristic,
+	               "decision heuristic in focused mode: vsids, vmtf (default), "
+	               "lrb")
+	    ->transform(CLI::CheckedTransformer(std::map<std::string, Heuristic>{
+	        {"vsids", Heuristic::vsids},
+	        {"vmtf", Heuristic::vmtf},
+	        {"lrb", Heuristic::lrb}}))
+	    ->group(g);
+	app.add_option("--focused-decay", opt->config.focused_decay,
+	               "activity decay in focused mode (default=1.25)")
+	    ->group(g);
+	app.add_option("--stable-decay", opt->config.stable_decay,
+	               "activity decay in stable mode (default=1.05)")
+	    ->group(g);
+	app.add_option("--stable-restart-base", opt->config.stable_restart_base,
+	               "luby restart base in stable mode (default=1024)")
+	    ->group(g);
+
+	// phases
+	g = "Phases";
+	app.add_option("--target-phases", opt->config.target_phases,
+	               "decide by the assignment of the largest conflict-free "
+	               "trail (0=off, 1=except in focused mode=default, 2=always)")
+	    ->group(g);
+	app.add_option("--rephase", opt->config.rephase,
+	               "periodically reset saved phases to original, inverted, "
+	               "best or random ones (0=off, 1=on=default)")
+	    ->group(g);
+	app.add_option("--rephase-interval", opt->config.rephase_interval,
+	               "conflicts before first rephase, grows linearly "
+	               "(default=1000)")
+	    ->group(g);
+	app.add_option("--walk-effort", opt->config.walk_effort,
+	               "flips per clause in local search rephases (default=10, "
+	               "0=no local search)")
+	    ->group(g);
 
 	// inprocessing options
 	g = "Inprocessing";
@@ -206,6 +458,10 @@ void setup_solve_command(CLI::App &app)
 	    ->group(g);
 	app.add_option("--bva", opt->config.bva, "bounded variable addition")
 	    ->group(g);
+	app.add_option("--threads", opt->config.threads,
+	               "number of threads for subsumption, vivification and "
+	               "elimination (default=1, all cores=0)")
+	    ->group(g);
 
 	// verbosity
 	g = "Verbosity";
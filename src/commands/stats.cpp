@@ -14,8 +14,8 @@ struct Options
 
 void run_stats_command(Options opt)
 {
-	auto [clauses, varCount] = parseCnf(opt.input);
-	auto sat = Cnf(varCount, std::move(clauses)); // clauses are copied here!
+	Cnf sat;
+	parseCnf(opt.input, sat);
 
 	// print statistics about sat
 	fmt::print("nvars  = {:>8}\n", sat.var_count());
@@ -72,8 +72,8 @@ void run_ui_command(Options opt)
 		screen.PostEvent(Event::Custom);
 	});
 
-	auto [originalClauses, varCount] = parseCnf(opt.cnfFile);
-	auto sat = Cnf(varCount, originalClauses); // clauses are copied here!
+	Cnf sat;
+	parseCnf(opt.cnfFile, sat);
 
 	SolverConfig config;
 	config.max_learnt = 1000;
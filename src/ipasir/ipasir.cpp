@@ -0,0 +1,113 @@
+#include "ipasir/ipasir.h"
+
+#include "sat/incremental.h"
+#include "util/logging.h"
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+using namespace dawn;
+
+namespace {
+
+struct IpasirSolver
+{
+	IncrementalSolver solver;
+	std::vector<Lit> clause;
+	std::vector<int32_t> learnt;
+
+	// IPASIR allows using any variable at any time, so all of them are
+	// frozen. Preprocessing still does everything but elimination.
+	Lit lit(int32_t x)
+	{
+		assert(x != 0);
+		while (solver.var_count() < std::abs(x))
+			solver.freeze(solver.add_var());
+		return Lit::fromDimacs(x);
+	}
+};
+
+IpasirSolver &get(void *solver) { return *static_cast<IpasirSolver *>(solver); }
+
+} // namespace
+
+const char *ipasir_signature() { return "dawn"; }
+
+void *ipasir_init()
+{
+	// The embedding program does not want to see our log. Only done once, so
+	// that the program can still change the level after the first init.
+	static std::once_flag quiet;
+	std::call_once(quiet, [] {
+		util::Logger::set_level(util::Logger::Level::warning);
+	});
+	return new IpasirSolver;
+}
+
+void ipasir_release(void *solver) { delete &get(solver); }
+
+void ipasir_add(void *solver, int32_t lit_or_zero)
+{
+	auto &s = get(solver);
+	if (lit_or_zero != 0)
+		s.clause.push_back(s.lit(lit_or_zero));
+	else
+	{
+		s.solver.add_clause(s.clause);
+		s.clause.clear();
+	}
+}
+
+void ipasir_assume(void *solver, int32_t lit)
+{
+	auto &s = get(solver);
+	s.solver.assume(s.lit(lit));
+}
+
+int ipasir_solve(void *solver)
+{
+	int r = get(solver).solver.solve();
+	return r == 30 ? 0 : r;
+}
+
+int32_t ipasir_val(void *solver, int32_t lit)
+{
+	auto &s = get(solver);
+	if (std::abs(lit) > s.solver.var_count())
+		return 0;
+	lbool v = s.solver.value(Lit::fromDimacs(lit));
+	return v == ltrue ? lit : v == lfalse ? -lit : 0;
+}
+
+int ipasir_failed(void *solver, int32_t lit)
+{
+	return get(solver).solver.failed(Lit::fromDimacs(lit)) ? 1 : 0;
+}
+
+void ipasir_set_terminate(void *solver, void *data,
+                          int (*terminate)(void *data))
+{
+	if (terminate)
+		get(solver).solver.set_terminate(
+		    [data, terminate] { return terminate(data) != 0; });
+	else
+		get(solver).solver.set_terminate({});
+}
+
+void ipasir_set_learn(void *solver, void *data, int max_length,
+                      void (*learn)(void *data, int32_t *clause))
+{
+	auto &s = get(solver);
+	if (!learn)
+	{
+		s.solver.set_learn(0, {});
+		return;
+	}
+	s.solver.set_learn(max_length, [&s, data, learn](std::span<const Lit> cl) {
+		s.learnt.clear();
+		for (Lit a : cl)
+			s.learnt.push_back(a.toDimacs());
+		s.learnt.push_back(0);
+		learn(data, s.learnt.data());
+	});
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// Standard interface for incremental SAT solvers, see
+// https://github.com/biotomas/ipasir. Literals are non-zero integers as in
+// DIMACS, variables are created implicitly by using them.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// name and version of the solver
+const char *ipasir_signature();
+
+// construct/destruct a solver instance. The first call to 'ipasir_init' lowers
+// dawn's (process-wide) log level to 'warning'.
+void *ipasir_init();
+void ipasir_release(void *solver);
+
+// add a literal to the current clause, or finish the clause with zero
+void ipasir_add(void *solver, int32_t lit_or_zero);
+
+// add an assumption for the next call to 'ipasir_solve'
+void ipasir_assume(void *solver, int32_t lit);
+
+// returns 10 = SAT, 20 = UNSAT, 0 = interrupted. Clears all assumptions.
+int ipasir_solve(void *solver);
+
+// after SAT: 'lit' if it is true, '-lit' if it is false (0 if unassigned)
+int32_t ipasir_val(void *solver, int32_t lit);
+
+// after UNSAT: 1 if assumption 'lit' was used to show UNSAT, 0 otherwise
+int ipasir_failed(void *solver, int32_t lit);
+
+// callback that is polled during search. Non-zero return stops the solver.
+void ipasir_set_terminate(void *solver, void *data,
+                          int (*terminate)(void *data));
+
+// callback for learnt clauses with at most 'max_length' literals. Clauses are
+// zero-terminated and only valid during the call.
+void ipasir_set_learn(void *solver, void *data, int max_length,
+                      void (*learn)(void *data, int32_t *clause));
+
+#ifdef __cplusplus
+}
+#endif
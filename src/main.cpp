@@ -15,8 +15,12 @@
 using namespace dawn;
 
 void setup_solve_command(CLI::App &app);
+void setup_count_command(CLI::App &app);
 void setup_simplify_command(CLI::App &app);
+void setup_extend_command(CLI::App &app);
 void setup_check_command(CLI::App &app);
+void setup_check_proof_command(CLI::App &app);
+void setup_convert_command(CLI::App &app);
 void setup_gen_command(CLI::App &app);
 void setup_gen_hard_command(CLI::App &app);
 void setup_gen_circuit_command(CLI::App &app);
@@ -54,10 +58,22 @@ int main(int argc, char *argv[])
 
 	auto cmd = app.add_subcommand("solve", "solve a CNF formula");
 	setup_solve_command(*cmd);
+	cmd = app.add_subcommand(
+	    "count", "approximately count the solutions of a CNF formula");
+	setup_count_command(*cmd);
 	cmd = app.add_subcommand("simplify", "simplify a CNF formula");
 	setup_simplify_command(*cmd);
+	cmd = app.add_subcommand(
+	    "extend", "map a solution of a simplified formula back to the original");
+	setup_extend_command(*cmd);
 	cmd = app.add_subcommand("check", "check a solution to a CNF formula");
 	setup_check_command(*cmd);
+	cmd = app.add_subcommand("check-proof",
+	                         "check a DRAT or LRAT proof of unsatisfiability");
+	setup_check_proof_command(*cmd);
+	cmd = app.add_subcommand(
+	    "convert", "convert a CNF formula to binary format for faster loading");
+	setup_convert_command(*cmd);
 	cmd = app.add_subcommand("gen", "generate a CNF instance");
 	cmd->require_subcommand(1);
 	auto cmd_gen = cmd->add_subcommand(
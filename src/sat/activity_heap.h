@@ -4,61 +4,84 @@
 
 namespace dawn {
 
-/** heap of variables with quick access to the most 'active' one */
-class ActivityHeap
+/**
+ * heap of variables with quick access to the most 'active' one
+ *   * d-ary max-heap (default 4-ary, i.e., one cache line of children). Heap
+ *     entries store a copy of the score next to the variable, so that sifting
+ *     only touches a single contiguous array.
+ *   * float scores are precise enough for ordering decisions and take half
+ *     the space. Scores are rescaled when they get close to overflowing.
+ */
+template <int Arity, class Score> class BasicActivityHeap
 {
-	double activity_inc_ = 1.0;
-	std::vector<double> activity_;
-	std::vector<int> arr_;
-	std::vector<int>
-	    location_; // -1 for vars that are not in the heap currently
+	static_assert(Arity >= 2);
 
-	static constexpr int parent(int i) { return (i - 1) / 2; }
-	static constexpr int left(int i) { return 2 * i + 1; }
-	static constexpr int right(int i) { return 2 * i + 2; }
+	// rescale everything when increments get this large
+	static constexpr Score limit_ = sizeof(Score) == 4 ? Score(1e30)
+	                                                   : Score(1e100);
 
-	bool pred(int x, int y) const { return activity_[x] > activity_[y]; }
-
-	int smaller_child(int i) const
+	struct Entry
 	{
-		if (right(i) < (int)arr_.size() && pred(arr_[right(i)], arr_[left(i)]))
-			return right(i);
-		else
-			return left(i);
-	}
+		Score score;
+		int var;
+	};
+
+	Score activity_inc_ = 1.0;
+	double decay_ = 1.05;
+	std::vector<Score> activity_;
+	std::vector<Entry> arr_;
+	std::vector<int> location_; // -1 for vars that are not in the heap
+
+	static constexpr int parent(int i) { return (i - 1) / Arity; }
+	static constexpr int first_child(int i) { return Arity * i + 1; }
 
 	void percolate_up(int i)
 	{
 		auto x = arr_[i];
 
-		for (int p = parent(i); i != 0 && pred(x, arr_[p]);
+		for (int p = parent(i); i != 0 && x.score > arr_[p].score;
 		     i = p, p = parent(i))
 		{
 			arr_[i] = arr_[p];
-			location_[arr_[i]] = i;
+			location_[arr_[i].var] = i;
 		}
 
 		arr_[i] = x;
-		location_[x] = i;
+		location_[x.var] = i;
 	}
 
 	void percolate_down(int i)
 	{
 		auto x = arr_[i];
+		int n = (int)arr_.size();
 
-		for (int c = smaller_child(i); c < (int)size() && pred(arr_[c], x);
-		     i = c, c = smaller_child(i))
+		while (true)
 		{
-			arr_[i] = arr_[c];
-			location_[arr_[i]] = i;
+			int c = first_child(i);
+			if (c >= n)
+				break;
+
+			// largest child
+			int end = std::min(c + Arity, n);
+			int best = c;
+			for (++c; c < end; ++c)
+				if (arr_[c].score > arr_[best].score)
+					best = c;
+
+			if (!(arr_[best].score > x.score))
+				break;
+			arr_[i] = arr_[best];
+			location_[arr_[i].var] = i;
+			i = best;
 		}
 
 		arr_[i] = x;
-		location_[x] = i;
+		location_[x.var] = i;
 	}
 
   public:
-	ActivityHeap(int var_count) : activity_(var_count), location_(var_count, -1)
+	BasicActivityHeap(int var_count)
+	    : activity_(var_count), location_(var_count, -1)
 	{
 		arr_.reserve(var_count);
 		for (int i = 0; i < var_count; i++)
@@ -71,6 +94,9 @@ class ActivityHeap
 	/** returns number of elements in the heap */
 	size_t size() const { return arr_.size(); }
 
+	/** current activity of a variable */
+	Score activity(int var) const { return activity_[var]; }
+
 	/** check if a var is currently present in th heap */
 	bool contains(int var) const { return location_[var] != -1; }
 
@@ -78,7 +104,7 @@ class ActivityHeap
 	int pop()
 	{
 		assert(!empty());
-		int r = arr_.front();
+		int r = arr_.front().var;
 		location_[r] = -1;
 		arr_.front() = arr_.back();
 		arr_.pop_back();
@@ -92,43 +118,67 @@ class ActivityHeap
 	{
 		if (contains(var))
 		{
-			percolate_up(location_[var]);
+			int i = location_[var];
+			arr_[i].score = activity_[var];
+			percolate_up(i);
 			percolate_down(location_[var]);
 		}
 		else
 		{
-			arr_.push_back(var);
+			arr_.push_back({activity_[var], var});
 			percolate_up((int)size() - 1);
 		}
 	}
 
+	// set activity of a variable directly (for heuristics other than VSIDS).
+	// updates heap if necessary.
+	void set_activity(int var, Score score)
+	{
+		activity_[var] = score;
+		if (contains(var))
+			push(var);
+	}
+
 	// increase activity of a variable. updates heap if necessary.
 	void bump_variable_activity(int var)
 	{
 		activity_[var] += activity_inc_;
 
+		// score only increases, so no need to percolate down
 		if (contains(var))
 		{
-			percolate_up(location_[var]);
-			percolate_down(location_[var]);
+			int i = location_[var];
+			arr_[i].score = activity_[var];
+			percolate_up(i);
 		}
 	}
 
+	// factor for 'decay_variable_activity'. Larger means faster decay, i.e.,
+	// more focus on recent conflicts. (default = 1.05, i.e., 1/0.95)
+	void set_decay(double decay)
+	{
+		assert(decay >= 1.0);
+		decay_ = decay;
+	}
+
 	// decrease activity of all variables by a factor
 	// (technically, we increase the activity_inc_ by a factor)
 	void decay_variable_activity()
 	{
-		// this number should be customizable
-		activity_inc_ *= 1.05;
+		activity_inc_ *= (Score)decay_;
 
 		// scale everything down if neccessary
-		if (activity_inc_ > 1e100)
+		if (activity_inc_ > limit_)
 		{
-			activity_inc_ *= 1e-100;
-			for (double &value : activity_)
-				value *= 1e-100;
+			activity_inc_ /= limit_;
+			for (Score &value : activity_)
+				value /= limit_;
+			for (Entry &e : arr_)
+				e.score /= limit_;
 		}
 	}
 };
 
+using ActivityHeap = BasicActivityHeap<4, float>;
+
 } // namespace dawn
@@ -0,0 +1,252 @@
+#include "sat/approxmc.h"
+
+#include "fmt/format.h"
+#include "sat/incremental.h"
+#include "util/logging.h"
+#include "util/random.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace dawn {
+
+std::string ApproxCount::to_string() const
+{
+	// little-endian digits in base 10^9
+	constexpr uint64_t base = 1'000'000'000;
+	assert(cell_count >= 0 && hash_count >= 0);
+	std::vector<uint64_t> digits;
+	for (uint64_t x = cell_count; x != 0; x /= base)
+		digits.push_back(x % base);
+	if (digits.empty())
+		return "0";
+	for (int i = 0; i < hash_count; ++i)
+	{
+		uint64_t carry = 0;
+		for (auto &d : digits)
+		{
+			d = 2 * d + carry;
+			carry = d / base;
+			d %= base;
+		}
+		if (carry)
+			digits.push_back(carry);
+	}
+
+	auto s = fmt::format("{}", digits.back());
+	for (size_t i = digits.size() - 1; i-- > 0;)
+		s += fmt::format("{:09}", digits[i]);
+	return s;
+}
+
+namespace {
+
+// number of (projected) solutions, but at most 'limit'. -1 if interrupted
+int64_t bounded_count(IncrementalSolver &solver,
+                      std::span<const int> projection, int64_t limit,
+                      std::stop_token stoken)
+{
+	int64_t count = 0;
+	int r = solver.enumerate(
+	    projection, [&] { return ++count < limit; }, stoken);
+	if (r == 30 && count < limit)
+		return -1;
+	return count;
+}
+
+// random XOR over the projection, after elimination of earlier pivots
+struct HashRow
+{
+	std::vector<uint8_t> coeffs; // indexed by position in the projection
+	std::vector<uint8_t> acts;   // activation variables (own one is last)
+	bool rhs = false;
+	int pivot = -1; // none if the row became trivial
+};
+
+// log2 of the estimate, for comparing them without overflow
+double log_estimate(ApproxCount const &c)
+{
+	if (c.cell_count == 0)
+		return -INFINITY;
+	return std::log2((double)c.cell_count) + c.hash_count;
+}
+
+} // namespace
+
+std::optional<ApproxCount> approx_count(Cnf sat,
+                                        std::span<const int> projection,
+                                        SolverConfig const &config,
+                                        ApproxMCConfig const &mc_config,
+                                        std::stop_token stoken)
+{
+	auto log = util::Logger("approxmc");
+	double eps = mc_config.epsilon;
+	double delta = mc_config.delta;
+	if (!(eps > 0) || !(delta > 0 && delta < 1))
+		throw std::runtime_error("invalid epsilon/delta for approximate count");
+
+	// parameters as given by ApproxMC
+	auto threshold = (int64_t)std::ceil(
+	    1 + 9.84 * (1 + eps / (1 + eps)) * (1 + 1 / eps) * (1 + 1 / eps));
+	int iterations = (int)std::ceil(17 * std::log2(3 / delta));
+
+	auto base = IncrementalSolver(std::move(sat), config);
+	std::vector<int> all;
+	if (projection.empty())
+	{
+		all.resize(base.var_count());
+		std::iota(all.begin(), all.end(), 0);
+		projection = all;
+	}
+	int n = (int)projection.size();
+	log.info("projection of {} variables, threshold = {}, iterations = {}", n,
+	         threshold, iterations);
+
+	// Preprocess once and share the result between all estimates. The
+	// projection is kept, as hash constraints are added later.
+	for (int v : projection)
+		base.freeze(v);
+	if (int r = base.solve(stoken); r == 30)
+		return std::nullopt;
+	else if (r == 20)
+		return ApproxCount{0, 0, true};
+
+	// small counts are done exactly
+	{
+		auto solver = base;
+		int64_t c = bounded_count(solver, projection, threshold, stoken);
+		if (c < 0)
+			return std::nullopt;
+		if (c < threshold)
+			return ApproxCount{c, 0, true};
+	}
+
+	auto rng = util::xoshiro256(mc_config.seed);
+	std::vector<ApproxCount> estimates;
+	std::vector<Lit> lits;
+	int prev_m = 1; // number of hashes in the previous estimate
+	for (int iter = 0; iter < iterations; ++iter)
+	{
+		// Hash i is a random XOR over the projection, enabled by assuming
+		// '-act[i]'. It is reduced by the previous ones (i.e., Gaussian
+		// elimination), pulling in their activation variables, which does not
+		// change the cell as long as all of them are enabled. Deciding
+		// non-pivot variables first, the pivots are then propagated instead of
+		// being found by conflicts. Blocking clauses of a query are retired by
+		// its selector afterwards.
+		auto solver = base;
+		std::vector<int> act;
+		std::vector<HashRow> rows;
+		std::vector<int> order;       // projection, pivots last
+		std::map<int, int64_t> cells; // (capped) cell size by number of hashes
+		auto cell_count = [&](int m) {
+			if (auto it = cells.find(m); it != cells.end())
+				return it->second;
+			while ((int)rows.size() < m)
+			{
+				auto row = HashRow{};
+				for (int i = 0; i < n; ++i)
+					row.coeffs.push_back(rng() & 1);
+				row.acts.assign(rows.size() + 1, 0);
+				row.acts.back() = 1;
+				row.rhs = rng() & 1;
+				for (auto const &r : rows)
+				{
+					if (r.pivot == -1 || !row.coeffs[r.pivot])
+						continue;
+					for (int i = 0; i < n; ++i)
+						row.coeffs[i] ^= r.coeffs[i];
+					for (size_t i = 0; i < r.acts.size(); ++i)
+						row.acts[i] ^= r.acts[i];
+					row.rhs ^= r.rhs;
+				}
+				auto it = std::ranges::find(row.coeffs, 1);
+				if (it != row.coeffs.end())
+					row.pivot = (int)(it - row.coeffs.begin());
+
+				act.push_back(solver.add_var());
+				lits.clear();
+				for (size_t i = 0; i < row.acts.size(); ++i)
+					if (row.acts[i])
+						lits.push_back(Lit(act[i], false));
+				for (int i = 0; i < n; ++i)
+					if (row.coeffs[i])
+						lits.push_back(Lit(projection[i], false));
+				solver.add_xor(lits, row.rhs);
+				rows.push_back(std::move(row));
+			}
+
+			std::vector<uint8_t> is_pivot(n, 0);
+			for (int i = 0; i < m; ++i)
+				if (rows[i].pivot != -1)
+					is_pivot[rows[i].pivot] = 1;
+			order.clear();
+			for (int i = 0; i < n; ++i)
+				if (!is_pivot[i])
+					order.push_back(projection[i]);
+			for (int i = m; i-- > 0;)
+				if (rows[i].pivot != -1)
+					order.push_back(projection[rows[i].pivot]);
+
+			int sel = solver.add_var();
+			for (int i = 0; i < m; ++i)
+				solver.assume(Lit(act[i], true));
+			solver.assume(Lit(sel, false));
+			int64_t c = bounded_count(solver, order, threshold, stoken);
+			solver.add_clause(std::array{Lit(sel, true)});
+			return cells[m] = c;
+		};
+		auto large = [&](int m) { return cell_count(m) >= threshold; };
+
+		// smallest number of hashes with a small cell, starting the search
+		// around the previous result (0 hashes is known to be large)
+		int lo = 0, hi = -1;
+		int m = std::clamp(prev_m, 1, n);
+		if (!large(m))
+			hi = m;
+		else
+			for (int step = 1, k = lo = m; hi == -1 && k < n; step *= 2)
+			{
+				k = std::min(lo + step, n);
+				if (large(k))
+					lo = k;
+				else
+					hi = k;
+			}
+		if (stoken.stop_requested())
+			return std::nullopt;
+		if (hi == -1)
+		{
+			log.info("iteration {}: no small cell found", iter);
+			continue;
+		}
+		while (hi - lo > 1)
+		{
+			int mid = (lo + hi) / 2;
+			if (large(mid))
+				lo = mid;
+			else
+				hi = mid;
+		}
+		if (stoken.stop_requested())
+			return std::nullopt;
+
+		auto e = ApproxCount{cells.at(hi), hi, false};
+		log.debug("iteration {}: {} * 2^{}", iter, e.cell_count, e.hash_count);
+		estimates.push_back(e);
+		prev_m = hi;
+	}
+
+	if (estimates.empty())
+		throw std::runtime_error("approximate count failed in all iterations");
+	auto mid = estimates.begin() + estimates.size() / 2;
+	std::ranges::nth_element(estimates, mid, {}, log_estimate);
+	return *mid;
+}
+
+} // namespace dawn
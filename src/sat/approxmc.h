@@ -0,0 +1,51 @@
+#pragma once
+
+#include "sat/cnf.h"
+#include "sat/stats.h"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+
+namespace dawn {
+
+// Approximate model counting by hashing (ApproxMC, Chakraborty, Meel and
+// Vardi 2013/2016):
+//   * random XOR constraints over the projection cut the solution space into
+//     cells. Their number is increased until a cell has less than 'threshold'
+//     solutions, which are then counted by enumeration.
+//   * the median of several such estimates (cell size times number of cells)
+//     is within a factor of (1 + epsilon) of the true count, with probability
+//     at least 1 - delta
+//   * each estimate uses a single incremental solver, branched off from the
+//     preprocessed formula. Hash constraints and blocking clauses are only
+//     active under assumptions, so they do not interfere between queries.
+struct ApproxMCConfig
+{
+	double epsilon = 0.8; // tolerance
+	double delta = 0.2;   // confidence
+	uint64_t seed = 0;
+};
+
+// a count of the form 'cell_count * 2^hash_count'
+struct ApproxCount
+{
+	int64_t cell_count = 0;
+	int hash_count = 0;
+	bool exact = false; // small enough to be counted without hashing
+
+	// in decimal (can be much larger than 64 bits)
+	std::string to_string() const;
+};
+
+// count solutions of 'sat', projected onto 'projection' (original variables,
+// empty = all of them). 'sat' must not be preprocessed yet. Returns nullopt
+// if interrupted.
+std::optional<ApproxCount> approx_count(Cnf sat,
+                                        std::span<const int> projection,
+                                        SolverConfig const &config,
+                                        ApproxMCConfig const &mc_config,
+                                        std::stop_token stoken = {});
+
+} // namespace dawn
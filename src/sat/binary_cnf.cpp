@@ -0,0 +1,412 @@
+#include "sat/binary_cnf.h"
+
+#include "fmt/format.h"
+#include "util/logging.h"
+#include "util/stopwatch.h"
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace dawn {
+
+namespace {
+
+// "dawncnf"/"dawnrec" + format version
+constexpr char magic[8] = {'d', 'a', 'w', 'n', 'c', 'n', 'f', 1};
+constexpr char magic_recon[8] = {'d', 'a', 'w', 'n', 'r', 'e', 'c', 1};
+
+constexpr uint32_t flag_contradiction = 1;
+constexpr uint32_t flag_reconstruction = 2;
+
+struct Header
+{
+	char magic[8];
+	uint32_t endian;        // 0x01020304 in native byte order
+	uint32_t clause_layout; // see 'clause_layout()'
+	uint32_t var_count;
+	uint32_t flags;
+	uint64_t unit_count;
+	uint64_t bin_count; // adjacency entries, i.e. twice the number of binaries
+	uint64_t clause_words;
+	uint64_t recon_words;
+};
+static_assert(sizeof(Header) % 8 == 0);
+
+struct ReconHeader
+{
+	char magic[8];
+	uint32_t endian;
+	uint32_t clause_layout;
+	uint64_t words;
+};
+
+// raw header word of some fixed clause. Guards against loading files written
+// by a build which lays out the 'Clause' bitfields differently.
+uint32_t clause_layout()
+{
+	uint32_t buf[4] = {};
+	std::construct_at((Clause *)buf, 3, Color::green)->set_flag(Flag::vivified);
+	return buf[0];
+}
+
+// read-only memory-mapped file
+class MappedFile
+{
+	void *map_ = nullptr;
+	size_t size_ = 0;
+
+  public:
+	explicit MappedFile(std::string const &filename)
+	{
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error(fmt::format("could not open '{}': {}",
+			                                     filename, strerror(errno)));
+		struct stat st = {};
+		if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+		{
+			::close(fd);
+			throw std::runtime_error(
+			    fmt::format("'{}' is not a regular file", filename));
+		}
+		size_ = st.st_size;
+		if (size_ > 0)
+		{
+			map_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (map_ == MAP_FAILED)
+			{
+				::close(fd);
+				throw std::runtime_error(fmt::format(
+				    "could not map '{}': {}", filename, strerror(errno)));
+			}
+			madvise(map_, size_, MADV_SEQUENTIAL);
+		}
+		::close(fd);
+	}
+
+	~MappedFile()
+	{
+		if (map_)
+			munmap(map_, size_);
+	}
+
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+
+	char const *data() const { return (char const *)map_; }
+	size_t size() const { return size_; }
+};
+
+// buffered writer of plain (native byte order) words
+class Writer
+{
+	FILE *f_;
+	std::string const &filename_;
+	std::vector<uint32_t> buf_;
+
+  public:
+	explicit Writer(std::string const &filename) : filename_(filename)
+	{
+		f_ = std::fopen(filename.c_str(), "wb");
+		if (!f_)
+			throw std::runtime_error(fmt::format("could not open '{}': {}",
+			                                     filename, strerror(errno)));
+		buf_.reserve(1 << 18);
+	}
+	~Writer()
+	{
+		if (f_)
+			std::fclose(f_);
+	}
+
+	Writer(Writer const &) = delete;
+	Writer &operator=(Writer const &) = delete;
+
+	void write_raw(void const *data, size_t n)
+	{
+		flush();
+		if (std::fwrite(data, 1, n, f_) != n)
+			throw std::runtime_error(fmt::format("error while writing '{}': {}",
+			                                     filename_, strerror(errno)));
+	}
+
+	void put(uint32_t x)
+	{
+		buf_.push_back(x);
+		if (buf_.size() == buf_.capacity())
+			flush();
+	}
+
+	void flush()
+	{
+		if (buf_.empty())
+			return;
+		auto n = buf_.size() * sizeof(uint32_t);
+		if (std::fwrite(buf_.data(), 1, n, f_) != n)
+			throw std::runtime_error(fmt::format("error while writing '{}': {}",
+			                                     filename_, strerror(errno)));
+		buf_.clear();
+	}
+
+	void close()
+	{
+		flush();
+		if (std::fclose(std::exchange(f_, nullptr)) != 0)
+			throw std::runtime_error(fmt::format("error while writing '{}': {}",
+			                                     filename_, strerror(errno)));
+	}
+};
+
+void check_compatible(std::string const &filename, uint32_t endian,
+                      uint32_t layout)
+{
+	if (endian != 0x01020304 || layout != clause_layout())
+		throw std::runtime_error(
+		    fmt::format("'{}' was written on an incompatible machine. Please "
+		                "re-create it from the DIMACS file",
+		                filename));
+}
+
+// validate the header (after the magic bytes have been checked)
+void check_header(std::string const &filename, Header const &h,
+                  size_t file_size)
+{
+	check_compatible(filename, h.endian, h.clause_layout);
+	if (h.var_count > (uint32_t)INT32_MAX / 2 || h.unit_count > file_size ||
+	    h.bin_count > file_size || h.clause_words > file_size ||
+	    h.recon_words > file_size)
+		throw std::runtime_error(
+		    fmt::format("'{}': malformed binary CNF", filename));
+	size_t expected =
+	    sizeof(Header) + (2 * h.var_count + 1) * 8 +
+	    (h.unit_count + h.bin_count + h.clause_words + h.recon_words) * 4;
+	if (file_size != expected)
+		throw std::runtime_error(fmt::format(
+		    "'{}': binary CNF has wrong size (truncated?)", filename));
+}
+
+} // namespace
+
+std::optional<BinaryCnfInfo> peek_binary_cnf(std::string const &filename)
+{
+	// stdin, pipes etc. can only be read once, so they are not peeked at
+	struct stat st = {};
+	if (filename.empty() || ::stat(filename.c_str(), &st) != 0 ||
+	    !S_ISREG(st.st_mode))
+		return std::nullopt;
+
+	FILE *f = std::fopen(filename.c_str(), "rb");
+	if (!f)
+		throw std::runtime_error(fmt::format("could not open '{}': {}",
+		                                     filename, strerror(errno)));
+	Header h;
+	size_t n = std::fread(&h, 1, sizeof(h), f);
+	std::fclose(f);
+
+	if (n < sizeof(magic) || std::memcmp(h.magic, magic, sizeof(magic)) != 0)
+		return std::nullopt;
+	if (n < sizeof(h))
+		throw std::runtime_error(
+		    fmt::format("'{}': truncated binary CNF", filename));
+	check_header(filename, h, st.st_size);
+	return BinaryCnfInfo{(int)h.var_count,
+	                     (h.flags & flag_reconstruction) != 0};
+}
+
+void write_binary_cnf(std::string const &filename, Cnf const &cnf,
+                      bool with_reconstruction)
+{
+	if (!cnf.xors.empty())
+		throw std::runtime_error("binary format does not support XORs");
+
+	util::Stopwatch sw;
+	sw.start();
+
+	int n = cnf.var_count();
+	auto clauses = cnf.clauses.raw();
+	std::vector<uint32_t> recon;
+	if (with_reconstruction)
+		recon = cnf.reconstruction().serialize();
+
+	Header h = {};
+	std::memcpy(h.magic, magic, sizeof(magic));
+	h.endian = 0x01020304;
+	h.clause_layout = clause_layout();
+	h.var_count = n;
+	h.flags = (cnf.contradiction ? flag_contradiction : 0) |
+	          (with_reconstruction ? flag_reconstruction : 0);
+	h.unit_count = cnf.units.size();
+	h.bin_count = 2 * cnf.bins.clause_count();
+	h.clause_words = clauses.size();
+	h.recon_words = recon.size();
+
+	auto w = Writer(filename);
+	w.write_raw(&h, sizeof(h));
+
+	auto offsets = std::vector<uint64_t>(2 * n + 1);
+	for (int i = 0; i < 2 * n; ++i)
+		offsets[i + 1] = offsets[i] + cnf.bins[Lit(i)].size();
+	assert(offsets.back() == h.bin_count);
+	w.write_raw(offsets.data(), offsets.size() * sizeof(uint64_t));
+
+	for (Lit a : cnf.units)
+		w.put(a);
+	for (int i = 0; i < 2 * n; ++i)
+		for (Lit b : cnf.bins[Lit(i)])
+			w.put(b);
+	w.write_raw(clauses.data(), clauses.size() * sizeof(Lit));
+	w.write_raw(recon.data(), recon.size() * sizeof(uint32_t));
+	w.close();
+
+	sw.stop();
+	util::Logger("reader").info("wrote binary CNF '{}' ({:.2f} MiB) in {:.2f}s",
+	                            filename,
+	                            (sizeof(h) + offsets.size() * 8 +
+	                             (h.unit_count + h.bin_count +
+	                              h.clause_words + h.recon_words) *
+	                                 4) /
+	                                1024. / 1024,
+	                            sw.secs());
+}
+
+void read_binary_cnf(std::string const &filename, Cnf &cnf)
+{
+	util::Stopwatch sw;
+	sw.start();
+
+	auto file = MappedFile(filename);
+	if (file.size() < sizeof(Header) ||
+	    std::memcmp(file.data(), magic, sizeof(magic)) != 0)
+		throw std::runtime_error(
+		    fmt::format("'{}' is not a binary CNF", filename));
+	auto h = (Header const *)file.data();
+	check_header(filename, *h, file.size());
+	auto malformed = [&] {
+		return std::runtime_error(
+		    fmt::format("'{}': malformed binary CNF", filename));
+	};
+
+	int n = (int)h->var_count;
+	auto offsets = std::span((uint64_t const *)(h + 1), 2 * n + 1);
+	auto words = (uint32_t const *)(offsets.data() + offsets.size());
+	auto units = std::span(words, h->unit_count);
+	auto adj = std::span(units.data() + units.size(), h->bin_count);
+	auto clauses = std::span((Lit const *)(adj.data() + adj.size()),
+	                         h->clause_words);
+	auto recon = std::span((uint32_t const *)(clauses.data() + clauses.size()),
+	                       h->recon_words);
+	auto check_lit = [&](Lit a) {
+		if (!a.proper() || a.var() >= n)
+			throw malformed();
+	};
+
+	auto r = Cnf(n);
+	r.contradiction = (h->flags & flag_contradiction) != 0;
+	for (uint32_t a : units)
+	{
+		check_lit(Lit(a));
+		r.units.push_back(Lit(a));
+	}
+	if (offsets[0] != 0 || offsets.back() != h->bin_count)
+		throw malformed();
+	for (int i = 0; i < 2 * n; ++i)
+	{
+		if (offsets[i] > offsets[i + 1] || offsets[i + 1] > h->bin_count)
+			throw malformed();
+		auto &list = r.bins[Lit(i)];
+		for (uint64_t k = offsets[i]; k < offsets[i + 1]; ++k)
+		{
+			auto b = Lit(adj[k]);
+			check_lit(b);
+			if (b.var() == Lit(i).var())
+				throw malformed();
+			list.push_back(b);
+		}
+	}
+	r.clauses.assign_raw(clauses, n);
+	if (h->flags & flag_reconstruction)
+		r.reconstruction() = Reconstruction::deserialize(recon);
+	else if (!recon.empty())
+		throw malformed();
+	cnf = std::move(r);
+
+	sw.stop();
+	util::Logger("reader").info(
+	    "loaded binary CNF '{}' ({:.2f} MiB) with {} vars and {} clauses in "
+	    "{:.2f}s",
+	    filename, file.size() / 1024. / 1024, n, cnf.clause_count(),
+	    sw.secs());
+}
+
+void write_reconstruction(std::string const &filename,
+                          Reconstruction const &recon)
+{
+	auto words = recon.serialize();
+
+	ReconHeader h = {};
+	std::memcpy(h.magic, magic_recon, sizeof(magic_recon));
+	h.endian = 0x01020304;
+	h.clause_layout = clause_layout();
+	h.words = words.size();
+
+	auto w = Writer(filename);
+	w.write_raw(&h, sizeof(h));
+	w.write_raw(words.data(), words.size() * sizeof(uint32_t));
+	w.close();
+}
+
+Reconstruction read_reconstruction(std::string const &filename)
+{
+	auto file = MappedFile(filename);
+	if (file.size() < sizeof(ReconHeader) ||
+	    std::memcmp(file.data(), magic_recon, sizeof(magic_recon)) != 0)
+		throw std::runtime_error(
+		    fmt::format("'{}' is not a reconstruction file", filename));
+	auto h = (ReconHeader const *)file.data();
+	check_compatible(filename, h->endian, h->clause_layout);
+	if (h->words > file.size() ||
+	    file.size() != sizeof(ReconHeader) + h->words * 4)
+		throw std::runtime_error(fmt::format(
+		    "'{}': reconstruction file has wrong size (truncated?)", filename));
+	return Reconstruction::deserialize(
+	    {(uint32_t const *)(h + 1), (size_t)h->words});
+}
+
+bool check_binary_solution(std::string const &filename, Assignment const &sol)
+{
+	if (peek_binary_cnf(filename)->has_reconstruction)
+		throw std::runtime_error(fmt::format(
+		    "'{}' contains a simplified formula, can not check solutions "
+		    "against it",
+		    filename));
+	auto cnf = Cnf();
+	read_binary_cnf(filename, cnf);
+	if (sol.var_count() < cnf.var_count())
+		throw std::runtime_error("solution has too few variables");
+
+	int64_t nFailed = cnf.contradiction ? 1 : 0;
+	for (Lit a : cnf.units)
+		nFailed += !sol.satisfied(a);
+	for (Lit a : cnf.all_lits())
+		for (Lit b : cnf.bins[a])
+			if (a < b)
+				nFailed += !sol.satisfied(a, b);
+	for (auto const &cl : cnf.clauses.all())
+		if (cl.color() == Color::blue)
+			nFailed += !sol.satisfied(cl);
+	if (nFailed)
+		util::Logger("parser").warning("{} clauses not satisfied", nFailed);
+	return nFailed == 0;
+}
+
+} // namespace dawn
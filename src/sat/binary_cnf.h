@@ -0,0 +1,52 @@
+#pragma once
+
+#include "sat/assignment.h"
+#include "sat/cnf.h"
+#include <optional>
+#include <string>
+
+namespace dawn {
+
+// Binary cache format for CNF formulas, as written by 'dawn convert'.
+//   * loading has (almost) no parsing cost: the file is memory-mapped, binary
+//     clauses are stored as adjacency arrays (CSR) and long clauses in the
+//     native 'ClauseStorage' layout
+//   * not portable between architectures/compilers (this is checked on
+//     load), so it is meant as a local cache, not for distributing instances
+//   * can optionally contain the reconstruction stack, so that a simplified
+//     formula can be cached and solutions mapped back to the original
+//
+// Layout: fixed header, bin offsets (uint64), units, bin adjacency, raw
+// clause storage, serialized reconstruction (all uint32).
+
+struct BinaryCnfInfo
+{
+	int var_count;
+	bool has_reconstruction;
+};
+
+// read the header of a binary CNF. Returns nullopt if the file is not in
+// binary format (e.g. DIMACS), or if it is not a regular file (stdin, pipes),
+// in which case nothing is read. Throws if it is, but can not be loaded.
+std::optional<BinaryCnfInfo> peek_binary_cnf(std::string const &filename);
+
+// Write all (non-removed) clauses, including learnt ones.
+//   * without the reconstruction, the file represents 'cnf' as a standalone
+//     formula. That is only correct if 'cnf' was not transformed (BVE etc).
+void write_binary_cnf(std::string const &filename, Cnf const &cnf,
+                      bool with_reconstruction);
+
+// read a binary CNF (overwriting 'cnf')
+void read_binary_cnf(std::string const &filename, Cnf &cnf);
+
+// standalone reconstruction stack, written by 'dawn simplify' next to the
+// simplified formula (same portability caveats as above)
+void write_reconstruction(std::string const &filename,
+                          Reconstruction const &recon);
+Reconstruction read_reconstruction(std::string const &filename);
+
+// check a solution against a binary CNF. Throws if the file contains a
+// simplified formula, as that can not be checked against.
+bool check_binary_solution(std::string const &filename, Assignment const &sol);
+
+} // namespace dawn
@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <cstring>
+#include <stdexcept>
 
 using namespace dawn;
 
@@ -78,6 +79,34 @@ void dawn::ClauseStorage::prune_black()
 
 void dawn::ClauseStorage::clear() { store_.resize(0); }
 
+void dawn::ClauseStorage::assign_raw(std::span<const Lit> data, int var_count)
+{
+	if (data.size() > CRef::max())
+		throw std::runtime_error("clause storage overflow");
+	store_.resize(data.size());
+	std::copy(data.begin(), data.end(), store_.begin());
+
+	// walk through all clauses, checking every header before following it
+	constexpr size_t header = sizeof(Clause) / sizeof(Lit);
+	for (size_t pos = 0; pos < store_.size();)
+	{
+		auto const &cl = *(Clause const *)&store_[pos];
+		if (pos + header + cl.capacity() > store_.size() ||
+		    cl.size() > cl.capacity() || cl.color() > Color::blue)
+		{
+			store_.resize(0);
+			throw std::runtime_error("malformed clause storage");
+		}
+		for (Lit a : cl.lits())
+			if (!a.proper() || a.var() >= var_count)
+			{
+				store_.resize(0);
+				throw std::runtime_error("malformed clause storage");
+			}
+		pos += header + cl.capacity();
+	}
+}
+
 void dawn::ImplCache::add_implied(Lit a) noexcept
 {
 	assert(a.proper());
@@ -11,6 +11,7 @@
 #include "util/iterator.h"
 #include "util/memory.h"
 #include "util/vector.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <functional>
@@ -221,6 +222,7 @@ inline Color max(Color a, Color b) { return a > b ? a : b; }
 enum class Flag : uint8_t
 {
 	vivified = 1, // clause was fully vivified at some point
+	core = 2,     // clause is needed for a proof (used by proof checking)
 };
 
 class Clause
@@ -478,6 +480,28 @@ class ClauseStorage
 		return add_clause(std::array<Lit, 2>{a, b}, Color::blue);
 	}
 
+	// append all clauses from another storage. The CRef's of these clauses
+	// are shifted by the previous size of this storage.
+	void append(ClauseStorage const &other)
+	{
+		size_t old_size = store_.size();
+		store_.reserve_with_spare(old_size + other.store_.size());
+		if (store_.size() + other.store_.size() > CRef::max())
+			throw std::runtime_error("clause storage overflow");
+		store_.set_size_unsafe(old_size + other.store_.size());
+		std::copy(other.store_.begin(), other.store_.end(),
+		          store_.begin() + old_size);
+	}
+
+	// raw content (clause headers and literals), for (de-)serialization.
+	//   * layout of the headers is compiler-specific, so this is only suitable
+	//     for caching, not as a portable file format
+	std::span<const Lit> raw() const { return {store_.begin(), store_.size()}; }
+
+	// replace all content by raw data previously obtained from 'raw()'.
+	//   * throws if the data is malformed or contains variables >= var_count
+	void assign_raw(std::span<const Lit> data, int var_count);
+
 	Clause &operator[](CRef i) { return *(Clause *)&store_[i]; }
 	const Clause &operator[](CRef i) const { return *(Clause *)&store_[i]; }
 
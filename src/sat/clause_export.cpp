@@ -0,0 +1,98 @@
+#include "sat/clause_export.h"
+
+#include <cassert>
+#include <utility>
+
+namespace dawn {
+
+ClauseExport::ClauseExport(Config const &config,
+                           std::function<void(std::span<const Lit>)> callback)
+    : config_(config), callback_(std::move(callback))
+{
+	assert(config_.capacity > 0);
+	queue_.slots.resize(config_.capacity);
+	delivering_.slots.resize(config_.capacity);
+	thread_ = std::thread([this] { run(); });
+}
+
+ClauseExport::~ClauseExport()
+{
+	{
+		auto lock = std::unique_lock(mutex_);
+		stop_ = true;
+	}
+	wakeup_.notify_one();
+	thread_.join();
+}
+
+bool ClauseExport::push(std::span<const Lit> cl)
+{
+	{
+		auto lock = std::unique_lock(mutex_);
+		pushed_ += 1;
+		size_t cap = config_.capacity;
+		if (queue_.count == cap)
+		{
+			dropped_ += 1;
+			if (config_.drop == DropPolicy::newest)
+				return false;
+			queue_.head = (queue_.head + 1) % cap;
+			queue_.count -= 1;
+		}
+		auto &slot = queue_.slots[(queue_.head + queue_.count) % cap];
+		slot.assign(cl.begin(), cl.end());
+		queue_.count += 1;
+	}
+	wakeup_.notify_one();
+	return true;
+}
+
+void ClauseExport::run()
+{
+	size_t cap = config_.capacity;
+	auto lock = std::unique_lock(mutex_);
+	while (true)
+	{
+		wakeup_.wait(lock, [&] { return queue_.count != 0 || stop_; });
+		if (queue_.count == 0)
+			return;
+
+		// take everything queued so far, and deliver without holding the lock
+		std::swap(queue_, delivering_);
+		busy_ = true;
+		lock.unlock();
+		for (size_t i = 0; i < delivering_.count; ++i)
+			callback_(delivering_.slots[(delivering_.head + i) % cap]);
+		lock.lock();
+		delivered_ += delivering_.count;
+		delivering_.head = delivering_.count = 0;
+		busy_ = false;
+		idle_.notify_all();
+	}
+}
+
+void ClauseExport::flush()
+{
+	auto lock = std::unique_lock(mutex_);
+	idle_.wait(lock, [&] { return queue_.count == 0 && !busy_; });
+}
+
+int64_t ClauseExport::pushed()
+{
+	auto lock = std::unique_lock(mutex_);
+	return pushed_;
+}
+
+int64_t ClauseExport::dropped()
+{
+	auto lock = std::unique_lock(mutex_);
+	return dropped_;
+}
+
+int64_t ClauseExport::delivered()
+{
+	auto lock = std::unique_lock(mutex_);
+	return delivered_;
+}
+
+} // namespace dawn
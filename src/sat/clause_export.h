@@ -0,0 +1,84 @@
+#pragma once
+
+#include "sat/clause.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace dawn {
+
+// Asynchronous export of learnt clauses, e.g. to another reasoning engine
+// running in the same process.
+//   * 'push' (called by the solver) only copies the clause into a bounded
+//     queue. The callback runs on a separate thread, so a slow consumer never
+//     stalls the search.
+//   * if the queue is full, clauses are dropped according to 'DropPolicy'
+//   * the queue is double-buffered: the delivery thread swaps out everything
+//     queued so far at once, so the lock is only held for short copies
+//   * filtering by size and LBD is done by the solver (see
+//     'IncrementalSolver::set_export'), using the limits of 'Config'
+class ClauseExport
+{
+  public:
+	enum class DropPolicy
+	{
+		newest, // keep the queue, drop the clause being pushed
+		oldest  // make room by dropping the oldest queued clause
+	};
+
+	struct Config
+	{
+		int max_size = 8;       // longer clauses are not exported
+		int max_lbd = 6;        // clauses with larger LBD are not exported
+		size_t capacity = 4096; // max number of queued clauses
+		DropPolicy drop = DropPolicy::newest;
+	};
+
+  private:
+	struct Queue
+	{
+		std::vector<std::vector<Lit>> slots; // ring buffer, slots are reused
+		size_t head = 0, count = 0;
+	};
+
+	Config config_;
+	std::function<void(std::span<const Lit>)> callback_;
+
+	std::mutex mutex_;
+	std::condition_variable wakeup_, idle_;
+	Queue queue_, delivering_;
+	bool busy_ = false, stop_ = false;
+	int64_t pushed_ = 0, dropped_ = 0, delivered_ = 0;
+	std::thread thread_;
+
+	void run();
+
+  public:
+	ClauseExport(Config const &config,
+	             std::function<void(std::span<const Lit>)> callback);
+
+	// delivers all clauses still queued before returning
+	~ClauseExport();
+
+	ClauseExport(ClauseExport const &) = delete;
+	ClauseExport &operator=(ClauseExport const &) = delete;
+
+	Config const &config() const { return config_; }
+
+	// queue a clause for delivery. Returns false if it was dropped.
+	bool push(std::span<const Lit> cl);
+
+	// wait until all clauses queued so far are delivered
+	void flush();
+
+	// statistics
+	int64_t pushed();
+	int64_t dropped();
+	int64_t delivered();
+};
+
+} // namespace dawn
@@ -2,6 +2,7 @@
 
 #include "fmt/format.h"
 #include "sat/probing.h"
+#include "sat/proof.h"
 #include "sat/propengine.h"
 #include "util/logging.h"
 #include "util/stats.h"
@@ -10,6 +11,7 @@
 #include <cassert>
 #include <random>
 #include <sstream>
+#include <utility>
 
 namespace dawn {
 
@@ -93,6 +95,66 @@ void Cnf::add_xor_clause_safe(Lit a, Lit b, Lit c, Lit d)
 	add_clause_safe({{a.neg(), b.neg(), c.neg(), d}});
 }
 
+void Cnf::add_xor(XorClause x)
+{
+	auto &v = x.vars;
+	switch (v.size())
+	{
+	case 0:
+		if (x.rhs)
+			add_empty();
+		break;
+	case 1:
+		add_unary(Lit(v[0], !x.rhs));
+		break;
+	case 2:
+		add_binary(Lit(v[0], false), Lit(v[1], !x.rhs));
+		add_binary(Lit(v[0], true), Lit(v[1], x.rhs));
+		break;
+	default:
+		assert(!proof);
+		xors.push_back(std::move(x));
+	}
+}
+
+namespace {
+// fold signs and fixed literals into 'rhs', remove pairs of equal variables
+XorClause normalize_xor(std::span<const Lit> lits, bool rhs)
+{
+	XorClause x;
+	x.rhs = rhs;
+	for (Lit a : lits)
+	{
+		assert(a.proper() || a.fixed());
+		if (a.proper())
+		{
+			x.rhs ^= a.sign();
+			x.vars.push_back(a.var());
+		}
+		else
+			x.rhs ^= a == Lit::one();
+	}
+	std::sort(x.vars.begin(), x.vars.end());
+	size_t j = 0;
+	for (size_t i = 0; i < x.vars.size(); ++i)
+		if (i + 1 < x.vars.size() && x.vars[i] == x.vars[i + 1])
+			++i;
+		else
+			x.vars[j++] = x.vars[i];
+	x.vars.resize(j);
+	return x;
+}
+} // namespace
+
+void Cnf::add_xor_safe(std::span<const Lit> lits, bool rhs)
+{
+	auto x = normalize_xor(lits, rhs);
+	if (x.vars.size() >= 3)
+		for (int v : x.vars)
+			freeze(v);
+	add_xor(std::move(x));
+}
+
 void Cnf::add_maj_clause_safe(Lit a, Lit b, Lit c, Lit d)
 {
 	add_clause_safe({{a.neg(), b, c}});
@@ -115,6 +177,32 @@ void Cnf::add_ite_clause_safe(Lit a, Lit b, Lit c, Lit d)
 	add_clause_safe({{a.neg(), c, d}});
 }
 
+void Cnf::write_proof(char kind, std::span<const Lit> cl)
+{
+	proof_buf_.clear();
+	for (Lit a : cl)
+		proof_buf_.push_back(recon_.outer(a));
+	if (kind == 'a')
+		proof->add(proof_buf_);
+	else
+		proof->del(proof_buf_);
+}
+
+void Cnf::finish_change(Clause const &cl)
+{
+	if (cl.color() != Color::black)
+	{
+		// no need to log anything if the clause did not actually change
+		proof_buf_.assign(cl.lits().begin(), cl.lits().end());
+		std::sort(proof_buf_.begin(), proof_buf_.end());
+		std::sort(proof_old_.begin(), proof_old_.end());
+		if (proof_buf_ == proof_old_)
+			return;
+		write_proof('a', cl.lits());
+	}
+	write_proof('d', proof_old_);
+}
+
 size_t Cnf::unary_count() const { return units.size(); }
 
 size_t Cnf::binary_count() const { return bins.clause_count(); }
@@ -182,14 +270,63 @@ void Cnf::renumber(std::span<const Lit> trans, int newVarCount)
 		assert(l.fixed() || l == Lit::elim() ||
 		       (l.proper() && l.var() < newVarCount));
 
+	// Proof logging is done by hand here, as most clauses are merely renamed,
+	// which does not change them in terms of outer variables. Old versions
+	// are deleted only at the very end, because they might be needed to derive
+	// the new ones (in particular, the equivalences themselves).
+	ProofWriter *proof_ = std::exchange(proof, nullptr);
+	std::vector<Lit> old_outer, old_cl, new_cl;
+	ClauseStorage deleted;
+	if (proof_)
+	{
+		for (int i = 0; i < var_count(); ++i)
+		{
+			old_outer.push_back(recon_.outer(Lit(i, false)));
+			if (trans[i].fixed())
+				proof_->add(std::array{old_outer[i] ^ trans[i].sign()});
+		}
+	}
+
+	// log replacement of 'old_cl' by 'new_cl' (both in outer variables)
+	auto log_replace = [&](bool removed) {
+		if (!proof_)
+			return;
+		std::sort(old_cl.begin(), old_cl.end());
+		std::sort(new_cl.begin(), new_cl.end());
+		if (!removed && old_cl == new_cl)
+			return;
+		if (!removed)
+			proof_->add(new_cl);
+		deleted.add_clause(old_cl, Color::blue);
+	};
+
 	recon_.renumber(trans, newVarCount);
 
+	// renumber external variables and frozen counts
+	for (Lit &a : external)
+		if (a.proper())
+			a = trans[a.var()] == Lit::elim() ? Lit::elim()
+			                                  : trans[a.var()] ^ a.sign();
+	if (!frozen_.empty())
+	{
+		auto frozen_old = std::exchange(frozen_, std::vector<int>(newVarCount));
+		for (int i = 0; i < (int)frozen_old.size(); ++i)
+		{
+			if (frozen_old[i] == 0)
+				continue;
+			assert(trans[i] != Lit::elim() || contradiction);
+			if (trans[i].proper())
+				frozen_[trans[i].var()] += frozen_old[i];
+		}
+	}
+
 	// renumber units
 	{
 		auto units_old = std::move(units);
 		units.clear();
 		for (Lit a : units_old)
 		{
+			Lit old = proof_ ? old_outer[a.var()] ^ a.sign() : Lit::undef();
 			a = trans[a.var()] ^ a.sign();
 			if (a == Lit::one())
 				continue;
@@ -199,6 +336,12 @@ void Cnf::renumber(std::span<const Lit> trans, int newVarCount)
 				add_unary(a);
 			else
 				assert(false); // disallows elim
+
+			// units are never deleted from the proof
+			if (proof_ && a == Lit::zero())
+				proof_->add({});
+			else if (proof_ && recon_.outer(a) != old)
+				proof_->add(std::array{recon_.outer(a)});
 		}
 	}
 
@@ -226,9 +369,24 @@ void Cnf::renumber(std::span<const Lit> trans, int newVarCount)
 					throw std::runtime_error(
 					    "invalid renumbering: elim/undef in binary clause");
 
+				if (proof_)
+				{
+					old_cl = {old_outer[a.var()] ^ a.sign(),
+					          old_outer[b.var()] ^ b.sign()};
+					new_cl.clear();
+					for (Lit x : {c, d})
+						if (x.proper() &&
+						    std::find(new_cl.begin(), new_cl.end(),
+						              recon_.outer(x)) == new_cl.end())
+							new_cl.push_back(recon_.outer(x));
+				}
+
 				// (true, x), (x, -x) -> tautology
 				if (c == Lit::one() || d == Lit::one() || c == d.neg())
+				{
+					log_replace(true);
 					continue;
+				}
 
 				// (false, false) -> ()
 				else if (c == Lit::zero() && d == Lit::zero())
@@ -245,6 +403,7 @@ void Cnf::renumber(std::span<const Lit> trans, int newVarCount)
 				// actual binary clause left
 				else
 					add_binary(c, d);
+				log_replace(false);
 			}
 		}
 	}
@@ -254,9 +413,23 @@ void Cnf::renumber(std::span<const Lit> trans, int newVarCount)
 	{
 		if (cl.color() == Color::black)
 			continue;
+		if (proof_)
+		{
+			old_cl.clear();
+			for (Lit a : cl.lits())
+				old_cl.push_back(old_outer[a.var()] ^ a.sign());
+		}
 		for (Lit &a : cl.lits())
 			a = trans[a.var()] ^ a.sign();
 		cl.normalize();
+		if (proof_)
+		{
+			new_cl.clear();
+			if (cl.color() != Color::black)
+				for (Lit a : cl.lits())
+					new_cl.push_back(recon_.outer(a));
+			log_replace(cl.color() == Color::black);
+		}
 		if (cl.color() == Color::black)
 			continue;
 		if (cl.size() == 0)
@@ -270,6 +443,31 @@ void Cnf::renumber(std::span<const Lit> trans, int newVarCount)
 	}
 	clauses.prune_black();
 
+	// renumber XORs. Their variables are frozen, so can only be eliminated
+	// after a contradiction (which makes the XORs irrelevant anyway).
+	{
+		auto xors_old = std::move(xors);
+		xors.clear();
+		std::vector<Lit> lits;
+		for (auto const &x : xors_old)
+		{
+			lits.clear();
+			for (int v : x.vars)
+				lits.push_back(trans[v]);
+			if (std::ranges::find(lits, Lit::elim()) != lits.end())
+			{
+				assert(contradiction);
+				continue;
+			}
+			add_xor(normalize_xor(lits, x.rhs));
+		}
+	}
+
+	// delete old versions of changed clauses
+	proof = proof_;
+	for (auto const &cl : deleted.all())
+		proof_->del(cl.lits());
+
 	assert(var_count() == newVarCount);
 }
 
@@ -279,6 +477,10 @@ size_t Cnf::memory_usage() const
 	r += units.capacity() * sizeof(Lit);
 	r += bins.memory_usage();
 	r += clauses.memory_usage();
+	r += external.capacity() * sizeof(Lit);
+	r += frozen_.capacity() * sizeof(int);
+	for (auto const &x : xors)
+		r += sizeof(XorClause) + x.vars.capacity() * sizeof(int);
 	return r;
 }
 
@@ -420,10 +622,14 @@ int run_unit_propagation(Cnf &sat)
 	}
 
 	// NOTE: this renumber() changes sat and thus invalidates p
+	int count = (int)p.trail().size();
 	sat.renumber(trans, newVarCount);
-	assert(sat.units.empty());
 
-	return (int)p.trail().size();
+	// XORs are not propagated by the PropEngineLight, but they shrink when
+	// renumbering, possibly into new units (or an empty clause)
+	if (sat.contradiction || !sat.units.empty())
+		count += run_unit_propagation(sat);
+	return count;
 }
 
 int run_scc(Cnf &sat)
@@ -441,6 +647,8 @@ int run_scc(Cnf &sat)
 	for (Lit a : sat.all_lits())
 		if (tarjan.dfs(a))
 		{
+			// x and -x are in the same component. Proof needs a unit first.
+			sat.proof_add(std::array{tarjan.comp[0]});
 			sat.add_empty();
 			return sat.var_count();
 		}
@@ -487,6 +695,8 @@ void run_binary_reduction(Cnf &cnf)
 			if (seen[b])
 			{
 				nFound += 1;
+				if ((int)a.neg() < (int)b) // every clause is found twice
+					cnf.proof_delete(std::array{a.neg(), b});
 				return true;
 			}
 
@@ -513,7 +723,7 @@ void run_binary_reduction(Cnf &cnf)
 	// 2, propCount / 1024. / 1024.);
 }
 
-void cleanup(Cnf &sat)
+void cleanup(Cnf &sat, int threads)
 {
 	auto log = util::Logger("cleanup");
 
@@ -524,7 +734,7 @@ void cleanup(Cnf &sat)
 		run_unit_propagation(sat);
 		if (run_scc(sat))
 			continue;
-		if (run_probing(sat))
+		if (run_probing(sat, threads))
 			continue;
 		break;
 	}
@@ -656,6 +866,8 @@ void print_stats(Cnf const &cnf)
 			log.info("nclauses[{:3}] = {:5} + {:5}", k, blue.bin(k),
 			         red.bin(k));
 	log.info("nclauses[all] = {:5} + {:5}", blue.count(), red.count());
+	if (!cnf.xors.empty())
+		log.info("nxors = {}", cnf.xors.size());
 }
 
 } // namespace dawn
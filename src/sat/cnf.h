@@ -8,18 +8,38 @@
 #include "util/logging.h"
 #include "util/stats.h"
 #include "util/vector.h"
+#include <array>
 #include <cassert>
 #include <string_view>
 #include <vector>
 
 namespace dawn {
 
+class ProofWriter;
+
+// XOR constraint 'vars[0] ^ vars[1] ^ ... = rhs'. Stored natively, as the CNF
+// encoding of an XOR is exponential in its length.
+struct XorClause
+{
+	std::vector<int> vars; // sorted, no duplicates, at least 3
+	bool rhs = false;
+};
+
 // Sat problem in conjunctive normal form, i.e. a set of clauses
 //   - clauses of lenght <= 2 are stored seprately from long clauses
 //   - does not contain watches or occurence lists or anything advanced
 class Cnf
 {
 	Reconstruction recon_;
+	std::vector<int> frozen_; // lazily resized
+
+	// add normalized XOR, short ones as clauses (no freezing)
+	void add_xor(XorClause x);
+
+	// temporaries for proof logging
+	std::vector<Lit> proof_buf_, proof_old_;
+	void write_proof(char kind, std::span<const Lit> cl);
+	void finish_change(Clause const &cl);
 
   public:
 	bool contradiction = false;
@@ -27,18 +47,51 @@ class Cnf
 	BinaryGraph bins;
 	ClauseStorage clauses;
 
+	// XOR constraints, only propagated by the PropEngine. Everything else
+	// ignores them, which is fine because their variables are frozen.
+	// Not compatible with proof logging.
+	std::vector<XorClause> xors;
+
+	// Inner literal of each external variable, i.e., as numbered by the user
+	// of an 'IncrementalSolver'. Kept up to date by 'renumber'. Entries can
+	// become fixed, or 'Lit::elim()' if the variable was eliminated.
+	std::vector<Lit> external;
+
+	// proof logging (optional, not owned)
+	//   * all 'add_*' methods log new clauses automatically
+	//   * removing or modifying clauses in-place has to be logged explicitly,
+	//     by 'proof_delete' or by wrapping the change into 'proof_begin_change'
+	//     and 'proof_end_change' (which logs the new version and deletes the
+	//     old one, or just the deletion if the clause was set to black)
+	//   * clauses are given in inner variables, translation is done here
+	ProofWriter *proof = nullptr;
+	void proof_add(std::span<const Lit> cl);
+	void proof_delete(std::span<const Lit> cl);
+	void proof_begin_change(Clause const &cl);
+	void proof_end_change(Clause const &cl);
+
 	// constructors
 	explicit Cnf(int n, ClauseStorage clauses_ = {});
 	Cnf() noexcept : Cnf(0) {}
 
-	// would work fine, just never used so we disallow copies to prevent bugs
-	Cnf(Cnf const &) = delete;
+	// explicit, so that copies do not happen by accident
+	explicit Cnf(Cnf const &) = default;
 	Cnf &operator=(Cnf const &) = delete;
+	Cnf(Cnf &&) = default;
+	Cnf &operator=(Cnf &&) = default;
 
 	// add/count variables
 	int add_var();
 	int var_count() const;
 
+	// Frozen variables are not removed by non-equivalence transformations
+	// (BVE, BCE, redshift), so they can appear in future clauses or
+	// assumptions. Freezing is counted, i.e., 'melt' has to be called as often
+	// as 'freeze'. Equivalent variables combine their counts when merged.
+	void freeze(int v);
+	void melt(int v);
+	bool is_frozen(int v) const;
+
 	// ranges for convenient iteration
 	auto all_vars() const { return util::iota_view(0, var_count()); }
 	auto all_lits() const
@@ -67,6 +120,11 @@ class Cnf
 	void add_maj_clause_safe(Lit a, Lit b, Lit c, Lit d); // a = b+c+d >= 2
 	void add_ite_clause_safe(Lit a, Lit b, Lit c, Lit d); // a = b ? c : d
 
+	// add XOR constraint 'lits[0] ^ lits[1] ^ ... = rhs' (normalizes it, fixed
+	// literals are allowed). Up to two variables, it is added as clauses.
+	// Otherwise its variables are frozen (permanently).
+	void add_xor_safe(std::span<const Lit> lits, bool rhs);
+
 	// number of clauses
 	size_t unary_count() const;
 	size_t binary_count() const;
@@ -81,6 +139,8 @@ class Cnf
 	void add_rule(std::span<const Lit> cl);
 	void add_rule(std::span<const Lit> cl, Lit pivot);
 	Assignment reconstruct_solution(Assignment const &a) const;
+	Reconstruction const &reconstruction() const { return recon_; }
+	Reconstruction &reconstruction() { return recon_; }
 
 	// renumber variables allowing for fixed and equivalent vars
 	//     - invalidates all CRefs
@@ -135,7 +195,8 @@ void run_binary_reduction(Cnf &);
 //   * TODO:
 //       * pure literal elimination
 //       * disconnected components?
-void cleanup(Cnf &);
+// 'threads' is passed on to the probing (the other parts are serial)
+void cleanup(Cnf &, int threads = 1);
 
 // check that
 //     * no contradiction
@@ -156,15 +217,67 @@ inline int Cnf::add_var() { return bins.add_var(); }
 
 inline int Cnf::var_count() const { return bins.var_count(); }
 
-inline void Cnf::add_empty() { contradiction = true; }
+inline void Cnf::freeze(int v)
+{
+	assert(0 <= v && v < var_count());
+	if (v >= (int)frozen_.size())
+		frozen_.resize(var_count(), 0);
+	frozen_[v] += 1;
+}
+
+inline void Cnf::melt(int v)
+{
+	assert(is_frozen(v));
+	frozen_[v] -= 1;
+}
+
+inline bool Cnf::is_frozen(int v) const
+{
+	return v < (int)frozen_.size() && frozen_[v] > 0;
+}
+
+inline void Cnf::proof_add(std::span<const Lit> cl)
+{
+	if (proof) [[unlikely]]
+		write_proof('a', cl);
+}
+
+inline void Cnf::proof_delete(std::span<const Lit> cl)
+{
+	if (proof) [[unlikely]]
+		write_proof('d', cl);
+}
+
+inline void Cnf::proof_begin_change(Clause const &cl)
+{
+	if (proof) [[unlikely]]
+		proof_old_.assign(cl.lits().begin(), cl.lits().end());
+}
+
+inline void Cnf::proof_end_change(Clause const &cl)
+{
+	if (proof) [[unlikely]]
+		finish_change(cl);
+}
+
+inline void Cnf::add_empty()
+{
+	proof_add({});
+	contradiction = true;
+}
 
 inline void Cnf::add_unary(Lit a)
 {
 	assert(a.proper() && a.var() < var_count());
+	proof_add(std::array{a});
 	units.push_back(a);
 }
 
-inline void Cnf::add_binary(Lit a, Lit b) { bins.add(a, b); }
+inline void Cnf::add_binary(Lit a, Lit b)
+{
+	proof_add(std::array{a, b});
+	bins.add(a, b);
+}
 
 inline CRef Cnf::add_ternary(Lit a, Lit b, Lit c, Color color)
 {
@@ -173,6 +286,7 @@ inline CRef Cnf::add_ternary(Lit a, Lit b, Lit c, Color color)
 	assert(c.proper() && c.var() < var_count());
 	assert(a.var() != b.var() && a.var() != c.var() && b.var() != c.var());
 
+	proof_add(std::array{a, b, c});
 	return clauses.add_clause({{a, b, c}}, color);
 }
 
@@ -188,6 +302,7 @@ inline CRef Cnf::add_long(std::span<const Lit> lits, Color color)
 			assert(lits[i].var() != lits[j].var());
 	assert(lits.size() >= 3);
 
+	proof_add(lits);
 	return clauses.add_clause(lits, color);
 }
 
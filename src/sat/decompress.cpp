@@ -0,0 +1,347 @@
+#include "sat/decompress.h"
+
+#include "fmt/format.h"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#ifdef DAWN_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef DAWN_HAVE_LZMA
+#include <lzma.h>
+#endif
+#ifdef DAWN_HAVE_BZIP2
+#include <bzlib.h>
+#endif
+
+namespace dawn {
+
+namespace {
+
+// RAII wrapper for a C file handle
+struct File
+{
+	FILE *f;
+
+	explicit File(std::string const &filename)
+	    : f(std::fopen(filename.c_str(), "rb"))
+	{
+		if (!f)
+			throw std::runtime_error(fmt::format(
+			    "could not open '{}': {}", filename, strerror(errno)));
+	}
+	~File() { std::fclose(f); }
+
+	File(File const &) = delete;
+	File &operator=(File const &) = delete;
+};
+
+#ifdef DAWN_HAVE_ZLIB
+class GzipDecompressor final : public Decompressor
+{
+	gzFile file_;
+
+  public:
+	explicit GzipDecompressor(std::string const &filename)
+	{
+		file_ = gzopen(filename.c_str(), "rb");
+		if (!file_)
+			throw std::runtime_error(
+			    fmt::format("could not open '{}'", filename));
+		gzbuffer(file_, 1 << 20);
+	}
+	~GzipDecompressor() { gzclose(file_); }
+
+	size_t read(char *buf, size_t n) override
+	{
+		// NOTE: 'gzread' handles concatenated streams just fine
+		int r = gzread(file_, buf, (unsigned)std::min(n, size_t(1) << 30));
+		if (r < 0)
+		{
+			int err;
+			throw std::runtime_error(
+			    fmt::format("gzip error: {}", gzerror(file_, &err)));
+		}
+		return r;
+	}
+};
+#endif
+
+#ifdef DAWN_HAVE_LZMA
+class XzDecompressor final : public Decompressor
+{
+	File file_;
+	lzma_stream strm_ = LZMA_STREAM_INIT;
+	std::unique_ptr<char[]> inbuf_;
+	static constexpr size_t inbuf_size = 1 << 20;
+	bool finished_ = false;
+
+  public:
+	explicit XzDecompressor(std::string const &filename)
+	    : file_(filename), inbuf_(new char[inbuf_size])
+	{
+		if (lzma_stream_decoder(&strm_, UINT64_MAX, LZMA_CONCATENATED) !=
+		    LZMA_OK)
+			throw std::runtime_error("could not initialize xz decoder");
+	}
+	~XzDecompressor() { lzma_end(&strm_); }
+
+	size_t read(char *buf, size_t n) override
+	{
+		if (finished_)
+			return 0;
+		strm_.next_out = (uint8_t *)buf;
+		strm_.avail_out = n;
+		while (strm_.avail_out == n)
+		{
+			lzma_action action = LZMA_RUN;
+			if (strm_.avail_in == 0)
+			{
+				strm_.next_in = (uint8_t const *)inbuf_.get();
+				strm_.avail_in = std::fread(inbuf_.get(), 1, inbuf_size, file_.f);
+				if (std::ferror(file_.f))
+					throw std::runtime_error("error while reading xz file");
+				if (strm_.avail_in == 0)
+					action = LZMA_FINISH;
+			}
+			auto ret = lzma_code(&strm_, action);
+			if (ret == LZMA_STREAM_END)
+			{
+				finished_ = true;
+				break;
+			}
+			if (ret != LZMA_OK)
+				throw std::runtime_error(
+				    fmt::format("xz decompression error (code {})", (int)ret));
+		}
+		return n - strm_.avail_out;
+	}
+};
+#endif
+
+#ifdef DAWN_HAVE_BZIP2
+class Bzip2Decompressor final : public Decompressor
+{
+	File file_;
+	BZFILE *bz_ = nullptr;
+	bool finished_ = false;
+
+	void open(void *unused, int nUnused)
+	{
+		int err;
+		bz_ = BZ2_bzReadOpen(&err, file_.f, 0, 0, unused, nUnused);
+		if (err != BZ_OK)
+			throw std::runtime_error("could not initialize bzip2 decoder");
+	}
+
+	void close()
+	{
+		int err;
+		BZ2_bzReadClose(&err, bz_);
+		bz_ = nullptr;
+	}
+
+  public:
+	explicit Bzip2Decompressor(std::string const &filename) : file_(filename)
+	{
+		open(nullptr, 0);
+	}
+	~Bzip2Decompressor()
+	{
+		if (bz_)
+			close();
+	}
+
+	size_t read(char *buf, size_t n) override
+	{
+		while (!finished_)
+		{
+			int err;
+			int r = BZ2_bzRead(&err, bz_, buf, (int)std::min(n, size_t(1) << 30));
+			if (err == BZ_OK)
+				return r;
+			if (err != BZ_STREAM_END)
+				throw std::runtime_error(
+				    fmt::format("bzip2 decompression error (code {})", err));
+
+			// end of one stream. Files created by parallel compressors
+			// (e.g. pbzip2) contain multiple concatenated streams.
+			void *unused;
+			int nUnused;
+			BZ2_bzReadGetUnused(&err, bz_, &unused, &nUnused);
+			std::string rest((char *)unused, nUnused);
+			close();
+			if (rest.empty() && std::feof(file_.f))
+				finished_ = true;
+			else
+				open(rest.data(), (int)rest.size());
+			if (r > 0)
+				return r;
+		}
+		return 0;
+	}
+};
+#endif
+
+[[noreturn, maybe_unused]] void unsupported(std::string const &filename,
+                                            std::string_view format,
+                                            std::string_view library)
+{
+	throw std::runtime_error(
+	    fmt::format("'{}' is {}-compressed, but dawn was built without {}",
+	                filename, format, library));
+}
+
+} // namespace
+
+Compression detect_compression(std::string const &filename)
+{
+	// Only regular files can be peeked at. For stdin and pipes (such as
+	// '<(zcat x.cnf)'), the magic bytes would be lost to the actual reader.
+	struct stat st = {};
+	if (filename.empty() || ::stat(filename.c_str(), &st) != 0 ||
+	    !S_ISREG(st.st_mode))
+		return Compression::none;
+
+	auto file = File(filename);
+	unsigned char magic[6] = {};
+	size_t n = std::fread(magic, 1, sizeof(magic), file.f);
+
+	if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+		return Compression::gzip;
+	if (n >= 6 && std::memcmp(magic, "\xfd" "7zXZ\0", 6) == 0)
+		return Compression::xz;
+	if (n >= 3 && std::memcmp(magic, "BZh", 3) == 0)
+		return Compression::bzip2;
+	return Compression::none;
+}
+
+std::unique_ptr<Decompressor> open_decompressor(std::string const &filename,
+                                                Compression compression)
+{
+	switch (compression)
+	{
+	case Compression::gzip:
+#ifdef DAWN_HAVE_ZLIB
+		return std::make_unique<GzipDecompressor>(filename);
+#else
+		unsupported(filename, "gzip", "zlib");
+#endif
+	case Compression::xz:
+#ifdef DAWN_HAVE_LZMA
+		return std::make_unique<XzDecompressor>(filename);
+#else
+		unsupported(filename, "xz", "liblzma");
+#endif
+	case Compression::bzip2:
+#ifdef DAWN_HAVE_BZIP2
+		return std::make_unique<Bzip2Decompressor>(filename);
+#else
+		unsupported(filename, "bzip2", "libbz2");
+#endif
+	case Compression::none:
+		break;
+	}
+	throw std::runtime_error("tried to decompress uncompressed file");
+}
+
+BlockStream::BlockStream(std::string const &filename, Compression compression)
+    : decompressor_(open_decompressor(filename, compression)),
+      worker_([this] { run(); })
+{}
+
+BlockStream::~BlockStream()
+{
+	{
+		auto lock = std::unique_lock(mutex_);
+		stopping_ = true;
+	}
+	cv_.notify_all();
+}
+
+void BlockStream::run()
+{
+	try
+	{
+		std::string carry; // incomplete line from the previous block
+		while (true)
+		{
+			// decompress a block, appended to the leftover of the last one
+			std::string block = std::move(carry);
+			size_t old_size = block.size();
+			block.resize(old_size + block_size);
+			size_t n = 0;
+			while (n < block_size)
+			{
+				size_t r = decompressor_->read(block.data() + old_size + n,
+				                               block_size - n);
+				if (r == 0)
+					break;
+				n += r;
+			}
+			block.resize(old_size + n);
+			bool eof = n < block_size;
+
+			// cut at the last line break
+			carry.clear();
+			if (!eof)
+			{
+				size_t pos = block.rfind('\n');
+				if (pos != std::string::npos)
+				{
+					carry.assign(block, pos + 1);
+					block.resize(pos + 1);
+				}
+				else
+				{
+					// no line break at all. Keep collecting.
+					carry = std::move(block);
+					continue;
+				}
+			}
+
+			auto lock = std::unique_lock(mutex_);
+			cv_.wait(lock,
+			         [&] { return stopping_ || blocks_.size() < max_blocks; });
+			if (stopping_)
+				return;
+			if (!block.empty())
+				blocks_.push_back(std::move(block));
+			if (eof)
+			{
+				done_ = true;
+				cv_.notify_all();
+				return;
+			}
+			cv_.notify_all();
+		}
+	}
+	catch (...)
+	{
+		auto lock = std::unique_lock(mutex_);
+		error_ = std::current_exception();
+		done_ = true;
+		cv_.notify_all();
+	}
+}
+
+bool BlockStream::next(std::string &block)
+{
+	auto lock = std::unique_lock(mutex_);
+	cv_.wait(lock, [&] { return done_ || !blocks_.empty(); });
+	if (blocks_.empty())
+	{
+		if (error_)
+			std::rethrow_exception(error_);
+		return false;
+	}
+	block = std::move(blocks_.front());
+	blocks_.pop_front();
+	total_size_ += block.size();
+	cv_.notify_all();
+	return true;
+}
+
+} // namespace dawn
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace dawn {
+
+enum class Compression
+{
+	none,
+	gzip,
+	xz,
+	bzip2
+};
+
+// detect compression of a file by its magic bytes. Anything but a regular
+// file (stdin, pipes, devices) is assumed to be uncompressed and not read.
+Compression detect_compression(std::string const &filename);
+
+// Streaming decompression of a whole file.
+//   * support for each format depends on the libraries found at build time,
+//     unsupported formats throw on construction
+class Decompressor
+{
+  public:
+	virtual ~Decompressor() = default;
+
+	// read up to 'n' bytes. Returns 0 at the end of the stream.
+	virtual size_t read(char *buf, size_t n) = 0;
+};
+
+std::unique_ptr<Decompressor> open_decompressor(std::string const &filename,
+                                                Compression compression);
+
+// Decompresses a file on a background thread, handing out the content in
+// blocks that always end at a line break (except possibly the last one).
+//   * at most a few blocks are buffered, so memory usage stays bounded
+//   * errors during decompression are re-thrown from 'next()'
+class BlockStream
+{
+	std::unique_ptr<Decompressor> decompressor_;
+
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::deque<std::string> blocks_;
+	bool done_ = false;     // no more blocks coming
+	bool stopping_ = false; // consumer is gone
+	std::exception_ptr error_;
+	int64_t total_size_ = 0;
+
+	std::jthread worker_; // declared last, so that it is joined first
+
+	void run();
+
+  public:
+	static constexpr size_t block_size = 4 << 20;
+	static constexpr size_t max_blocks = 4;
+
+	BlockStream(std::string const &filename, Compression compression);
+	~BlockStream();
+
+	BlockStream(BlockStream const &) = delete;
+	BlockStream &operator=(BlockStream const &) = delete;
+
+	// get the next block. Returns false at the end of the stream.
+	bool next(std::string &block);
+
+	// total number of (decompressed) bytes handed out so far
+	int64_t total_size() const { return total_size_; }
+};
+
+} // namespace dawn
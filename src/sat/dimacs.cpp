@@ -1,49 +1,184 @@
 #include "sat/dimacs.h"
 
-#include "util/io.h"
+#include "sat/binary_cnf.h"
+#include "sat/decompress.h"
+#include "sat/parallel.h"
 #include "util/logging.h"
+#include "util/stopwatch.h"
+#include <atomic>
 #include <cctype>
+#include <cerrno>
 #include <climits>
 #include <cstdio>
 #include <cstring>
-#include <iostream>
+#include <fcntl.h>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <vector>
 
 namespace dawn {
 
+namespace {
+
+// Read-only view of a whole file (or stdin), followed by a '\0' sentinel. This
+// allows the parser to skip bounds-checks on every character.
+//   * regular files are mapped into memory (no copy at all)
+//   * otherwise (stdin, or if the file size is a multiple of the page size so
+//     that there is no room for the sentinel), the content is read into a
+//     string using large read() calls
+class InputBuffer
+{
+	std::string storage_;
+	void *map_ = nullptr;
+	size_t map_size_ = 0;
+	std::string_view data_;
+
+  public:
+	// filename = "" means reading from stdin
+	explicit InputBuffer(std::string const &filename)
+	{
+		if (filename.empty())
+			read_all(STDIN_FILENO, 0);
+		else
+			open_file(filename);
+
+		util::Logger("reader").info(
+		    "read {:.2f} MiB from {} ({})", data_.size() / 1024. / 1024,
+		    filename.empty() ? "stdin" : fmt::format("'{}'", filename),
+		    map_ ? "mmap" : "read");
+	}
+
+	~InputBuffer()
+	{
+		if (map_)
+			munmap(map_, map_size_);
+	}
+
+	InputBuffer(InputBuffer const &) = delete;
+	InputBuffer &operator=(InputBuffer const &) = delete;
+
+	// content without the sentinel
+	std::string_view view() const { return data_; }
+
+  private:
+	void read_all(int fd, size_t size_hint)
+	{
+		size_t size = 0;
+		storage_.resize(std::max(size_hint + 1, size_t(1) << 20));
+		while (true)
+		{
+			if (size == storage_.size())
+				storage_.resize(2 * storage_.size());
+			auto r = ::read(fd, storage_.data() + size, storage_.size() - size);
+			if (r < 0 && errno == EINTR)
+				continue;
+			if (r < 0)
+				throw std::runtime_error(
+				    fmt::format("error while reading: {}", strerror(errno)));
+			if (r == 0)
+				break;
+			size += r;
+		}
+		storage_.resize(size);
+		data_ = storage_; // std::string always has a '\0' after the end
+	}
+
+	void open_file(std::string const &filename)
+	{
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error(fmt::format("could not open '{}': {}",
+			                                     filename, strerror(errno)));
+		struct stat st = {};
+		size_t page = sysconf(_SC_PAGESIZE);
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+		    st.st_size % page != 0)
+		{
+			// bytes beyond the end of the file (up to the page boundary) are
+			// zero-filled by mmap, which gives us the sentinel for free
+			map_size_ = st.st_size;
+			map_ = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (map_ == MAP_FAILED)
+				map_ = nullptr;
+			else
+			{
+				madvise(map_, map_size_, MADV_SEQUENTIAL);
+				data_ = std::string_view((char const *)map_, map_size_);
+			}
+		}
+		if (!map_)
+		{
+			try
+			{
+				read_all(fd, S_ISREG(st.st_mode) ? st.st_size : 0);
+			}
+			catch (...)
+			{
+				::close(fd);
+				throw;
+			}
+		}
+		::close(fd);
+	}
+};
+
 // Custom text parser
+//   * the character after the parsed range must be readable, and either the
+//     '\0' sentinel or (when parsing a chunk) part of the following line
+//   * character classes are checked manually, which is quite a bit faster than
+//     the locale-aware functions from <cctype>
 class Parser
 {
-	std::string content;
-	size_t pos = 0;
+	char const *pos_;
+	char const *end_;
+
+	static bool is_digit(char c) { return (unsigned)(c - '0') < 10; }
+	static bool is_alpha(char c) { return (unsigned)((c | 32) - 'a') < 26; }
+	static bool is_space(char c)
+	{
+		return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' ||
+		       c == '\f';
+	}
 
   public:
+	explicit Parser(std::string_view content)
+	    : pos_(content.data()), end_(content.data() + content.size())
+	{}
 	Parser(const Parser &) = delete;
 	Parser &operator=(const Parser &) = delete;
 
-	inline char operator*() { return pos < content.size() ? content[pos] : 0; }
+	// current character. Returns '\0' at the end of the range
+	inline char operator*() const { return pos_ < end_ ? *pos_ : 0; }
+
+	inline void operator++() { ++pos_; }
 
-	inline void operator++() { ++pos; }
+	inline bool at_number() const
+	{
+		return pos_ < end_ && (is_digit(*pos_) || *pos_ == '-');
+	}
 
 	inline int parseInt()
 	{
 		int r = 0;
 		int s = 1;
-		if (**this == '-')
+		if (*pos_ == '-')
 		{
 			s = -1;
-			++*this;
+			++pos_;
 		}
 
-		if (!isdigit(**this))
+		if (!is_digit(*pos_))
 			throw std::runtime_error("unexpected character (not a digit)");
 
-		while (isdigit(**this))
+		while (is_digit(*pos_))
 		{
-			int d = **this - '0';
-			++*this;
+			int d = *pos_ - '0';
+			++pos_;
 			if (r > (INT_MAX - d) / 10)
 				throw std::runtime_error("integer overflow while parsing CNF");
 			r = 10 * r + d;
@@ -53,68 +188,51 @@ class Parser
 
 	std::string parseString()
 	{
-		std::string r;
-		if (!isalpha(**this))
+		auto start = pos_;
+		if (!is_alpha(*pos_))
 			throw std::runtime_error("unexpected character (not an alphabet)");
-		while (isalpha(**this))
-		{
-			r += **this;
-			++*this;
-		}
-		return r;
+		while (is_alpha(*pos_))
+			++pos_;
+		return std::string(start, pos_);
 	}
 
 	/** skip whitespace (including newlines) */
 	inline void skipWhite()
 	{
-		while (isspace(**this))
-			++*this;
+		while (is_space(*pos_))
+			++pos_;
 	}
 
 	/** advances the stream to the next line */
 	inline void skipLine()
 	{
-		while (**this != 0 && **this != '\n')
-			++*this;
-		if (**this == '\n')
-			++*this;
-	}
-
-	Parser(std::string filename)
-	{
-		auto log = util::Logger("reader");
-		if (!filename.empty())
-		{
-			// TODO: this is weirdly slow. investigate.
-			// 		cat foo.cnf | ./dawn stats
-			// is faster than
-			// 	   ./dawn stats foo.cnf
-			// even stranger, not the reading itself is slower, but the parsing
-			// afterwards. Must be a difference in cache state? weird...
-			content = util::read_file(filename);
-			log.info("read {:.2f} MiB from '{}'", content.size() / 1024. / 1024,
-			         filename);
-		}
-		else
-		{
-			std::istreambuf_iterator<char> begin(std::cin), end;
-			content = std::string(begin, end);
-			log.info("read {:.2f} MiB from stdin",
-			         content.size() / 1024. / 1024);
-		}
+		while (*pos_ != 0 && *pos_ != '\n')
+			++pos_;
+		if (*pos_ == '\n')
+			++pos_;
 	}
 };
-std::pair<ClauseStorage, int> parseCnf(std::string filename)
-{
-	auto parser = Parser(filename);
-	auto log = util::Logger("parser");
-	ClauseStorage clauses;
 
-	int headerVarCount = -1;
-	int headerClauseCount = -1;
+// header and counts of (a chunk of) a CNF file
+struct CnfChunk
+{
+	ClauseStorage clauses; // only used when parsing in chunks
+	std::vector<Lit> partial; // incomplete clause at the end of the chunk
 	int varCount = 0;
 	int clauseCount = 0;
-	std::vector<Lit> clause;
+	int headerVarCount = -1;
+	int headerClauseCount = -1;
+};
+
+// Parse a part of a CNF file, calling 'sink(lits)' for each clause.
+//   * must not start or end in the middle of a line
+//   * a clause can continue from the previous call (with the same 'r'),
+//     which is needed for streaming input
+template <class Sink>
+void parse_chunk(std::string_view content, CnfChunk &r, Sink &&sink)
+{
+	auto parser = Parser(content);
+	auto &clause = r.partial;
 	while (true)
 	{
 		parser.skipWhite();
@@ -137,29 +255,29 @@ std::pair<ClauseStorage, int> parseCnf(std::string filename)
 			parser.skipWhite();
 			if (parser.parseString() != "cnf")
 				throw std::runtime_error("invalid 'p' line");
-			if (headerVarCount != -1 || headerClauseCount != -1)
+			if (r.headerVarCount != -1 || r.headerClauseCount != -1)
 				throw std::runtime_error("duplicate 'p' line");
 			parser.skipWhite();
-			headerVarCount = parser.parseInt();
+			r.headerVarCount = parser.parseInt();
 			parser.skipWhite();
-			headerClauseCount = parser.parseInt();
+			r.headerClauseCount = parser.parseInt();
 			continue;
 		}
 
 		// integer
-		else if (isdigit(*parser) || *parser == '-')
+		else if (parser.at_number())
 		{
 			auto x = parser.parseInt();
 			if (x == 0)
 			{
-				clauseCount++;
-				clauses.add_clause(clause, Color::blue);
+				r.clauseCount++;
+				sink(std::span<const Lit>(clause));
 				clause.resize(0);
 			}
 			else
 			{
 				auto lit = Lit::fromDimacs(x);
-				varCount = std::max(varCount, lit.var() + 1);
+				r.varCount = std::max(r.varCount, lit.var() + 1);
 				clause.push_back(lit);
 			}
 			continue;
@@ -169,32 +287,171 @@ std::pair<ClauseStorage, int> parseCnf(std::string filename)
 			throw std::runtime_error(std::string("unexpected character: '") +
 			                         *parser + "'");
 	}
+}
+
+// Find a position >= 'pos' that is safe to split the CNF at, i.e. the start of
+// a line following a line that consists of literals and ends with a single
+// '0'. Note that comment lines (or the header) can end in '0' as well. Returns
+// content.size() if there is no such position.
+size_t find_split(std::string_view content, size_t pos)
+{
+	while (true)
+	{
+		// end of the line containing 'pos' (or the one starting right there)
+		size_t end = content.find('\n', pos == 0 ? 0 : pos - 1);
+		if (end == std::string_view::npos)
+			return content.size();
+		pos = end + 1;
+
+		// check the line before 'pos'
+		size_t start = content.rfind('\n', end - 1);
+		start = (end == 0 || start == std::string_view::npos) ? 0 : start + 1;
+		auto line = content.substr(start, end - start);
+		auto first = line.find_first_not_of(" \t\r");
+		auto last = line.find_last_not_of(" \t\r");
+		if (first == std::string_view::npos)
+			continue;
+		if (!(isdigit(line[first]) || line[first] == '-'))
+			continue;
+		if (line[last] != '0')
+			continue;
+		if (last != first && !isspace(line[last - 1]))
+			continue;
+		return pos;
+	}
+}
+
+// Split into chunks of at least 'min_chunk_size' bytes each (a few MiB by
+// default), separated at clause boundaries, and tokenize them concurrently,
+// calling 'sink(chunk, lits)' for each clause.
+template <class Sink>
+std::vector<CnfChunk> parse_chunks(std::string_view content, int threads,
+                                   Sink &&sink, size_t min_chunk_size = 4 << 20)
+{
+	threads = effective_threads(threads, content.size() / min_chunk_size);
+	std::vector<size_t> splits = {0};
+	for (int t = 1; t < threads; ++t)
+		splits.push_back(std::max(
+		    splits.back(), find_split(content, content.size() * t / threads)));
+	splits.push_back(content.size());
+
+	auto chunks = std::vector<CnfChunk>(threads);
+	run_parallel(threads, [&](int t) {
+		auto &c = chunks[t];
+		parse_chunk(content.substr(splits[t], splits[t + 1] - splits[t]), c,
+		            [&](std::span<const Lit> cl) { sink(c, cl); });
+	});
+	return chunks;
+}
+
+// merge header and counts of a later chunk 'c' into 'r'
+void merge_counts(CnfChunk &r, CnfChunk &c)
+{
+	// chunks are split at clause boundaries, so this can not happen
+	if (!r.partial.empty())
+		throw std::runtime_error("incomplete clause between chunks");
+	r.partial = std::move(c.partial);
+
+	if (c.headerVarCount != -1)
+	{
+		if (r.headerVarCount != -1)
+			throw std::runtime_error("duplicate 'p' line");
+		r.headerVarCount = c.headerVarCount;
+		r.headerClauseCount = c.headerClauseCount;
+	}
+	r.varCount = std::max(r.varCount, c.varCount);
+	r.clauseCount += c.clauseCount;
+}
 
-	if (!clause.empty())
+// merge all chunks (including their clauses) into the first one
+void merge_chunks(std::vector<CnfChunk> &chunks)
+{
+	for (size_t t = 1; t < chunks.size(); ++t)
+	{
+		merge_counts(chunks[0], chunks[t]);
+		chunks[0].clauses.append(chunks[t].clauses);
+		chunks[t].clauses = {};
+	}
+}
+
+// check counts against the header. Returns final number of variables.
+int check_counts(CnfChunk const &r)
+{
+	if (!r.partial.empty())
 		throw std::runtime_error("incomplete clause at end of file");
 
+	int varCount = r.varCount;
+
 	// there might be unused variables. In that case, respect the header
-	if (headerVarCount > varCount)
-		varCount = headerVarCount;
+	if (r.headerVarCount > varCount)
+		varCount = r.headerVarCount;
 
-	if (headerVarCount != -1 && headerVarCount != varCount)
+	if (r.headerVarCount != -1 && r.headerVarCount != varCount)
 		throw std::runtime_error(
 		    fmt::format("wrong number of variables: header said {}, "
 		                "actually got {}",
-		                headerVarCount, varCount));
-	if (headerClauseCount != -1 && headerClauseCount != clauseCount)
+		                r.headerVarCount, varCount));
+	if (r.headerClauseCount != -1 && r.headerClauseCount != r.clauseCount)
 		throw std::runtime_error(
 		    fmt::format("wrong number of clauses: header said {}, "
 		                "actually got {}",
-		                headerClauseCount, clauseCount));
+		                r.headerClauseCount, r.clauseCount));
+	return varCount;
+}
+
+// Parse a whole CNF input with a single tokenizer, calling 'sink' for each
+// clause. Compressed files are decompressed on a separate thread, so that
+// decompression and parsing overlap. Returns the (decompressed) input size.
+template <class Sink>
+int64_t parse_sequential(std::string const &filename, Compression compression,
+                         CnfChunk &r, Sink &&sink)
+{
+	if (compression == Compression::none)
+	{
+		auto input = InputBuffer(filename);
+		parse_chunk(input.view(), r, sink);
+		return input.view().size();
+	}
 
-	log.info("parsed {} vars and {} clauses", varCount, clauseCount);
+	BlockStream stream(filename, compression);
+	std::string block;
+	while (stream.next(block))
+		parse_chunk(block, r, sink);
+	util::Logger("reader").info("decompressed {:.2f} MiB from '{}'",
+	                            stream.total_size() / 1024. / 1024, filename);
+	return stream.total_size();
+}
+
+// parse into temporary per-thread storage
+std::vector<CnfChunk> parse_chunks(std::string const &filename, int threads,
+                                   int64_t &size)
+{
+	if (auto compression = detect_compression(filename);
+	    compression != Compression::none)
+	{
+		auto chunks = std::vector<CnfChunk>(1);
+		auto &c = chunks[0];
+		size = parse_sequential(filename, compression, c,
+		                        [&c](std::span<const Lit> cl) {
+			                        c.clauses.add_clause(cl, Color::blue);
+		                        });
+		return chunks;
+	}
 
-	return {std::move(clauses), varCount};
+	auto input = InputBuffer(filename);
+	size = input.view().size();
+	return parse_chunks(input.view(), threads,
+	                    [](CnfChunk &c, std::span<const Lit> cl) {
+		                    c.clauses.add_clause(cl, Color::blue);
+	                    });
 }
-void parseAssignment(std::string filename, Assignment &sol)
+
+// Parse a solution in the usual 's ...' / 'v ...' format, calling 'f(lit)'
+// for each literal of the 'v' lines.
+template <class F> void parse_solution(std::string const &filename, F &&f)
 {
-	auto parser = Parser(filename);
+	auto input = InputBuffer(filename);
+	auto parser = Parser(input.view());
 
 	while (true)
 	{
@@ -228,10 +485,7 @@ void parseAssignment(std::string filename, Assignment &sol)
 				int x = parser.parseInt();
 				if (x == 0)
 					break;
-				auto lit = Lit::fromDimacs(x);
-				if (lit.var() >= sol.var_count())
-					throw std::runtime_error("invalid literal in solution");
-				sol.set(lit);
+				f(Lit::fromDimacs(x));
 			}
 		}
 
@@ -239,9 +493,289 @@ void parseAssignment(std::string filename, Assignment &sol)
 			throw std::runtime_error(std::string("unexpected character: '") +
 			                         *parser + "'");
 	}
+}
+
+// Size of a regular file, nullopt for stdin and special files like pipes
+// (e.g. 'dawn solve <(zcat x.cnf)'). Those can only be read once, so they are
+// neither sniffed for binary/compressed formats nor split by size.
+std::optional<size_t> regular_file_size(std::string const &filename)
+{
+	struct stat st = {};
+	if (filename.empty() || ::stat(filename.c_str(), &st) != 0 ||
+	    !S_ISREG(st.st_mode))
+		return std::nullopt;
+	return st.st_size;
+}
+
+void log_parse(CnfChunk const &r, int varCount, int64_t size,
+               util::Stopwatch &sw)
+{
+	sw.stop();
+	util::Logger("parser").info(
+	    "parsed {} vars and {} clauses in {:.2f}s ({:.0f} MiB/s)", varCount,
+	    r.clauseCount, sw.secs(), size / 1024. / 1024 / sw.secs());
+}
+
+} // namespace
+
+std::pair<ClauseStorage, int> parseCnf(std::string filename, int threads)
+{
+	if (auto info = peek_binary_cnf(filename))
+	{
+		if (info->has_reconstruction)
+			throw std::runtime_error(fmt::format(
+			    "'{}' contains a simplified formula, which can only be solved "
+			    "directly",
+			    filename));
+		Cnf cnf;
+		read_binary_cnf(filename, cnf);
+		ClauseStorage clauses;
+		if (cnf.contradiction)
+			clauses.add_clause({}, Color::blue);
+		for (Lit a : cnf.units)
+			clauses.add_clause({{a}}, Color::blue);
+		for (Lit a : cnf.all_lits())
+			for (Lit b : cnf.bins[a])
+				if (a < b)
+					clauses.add_binary(a, b);
+		for (auto const &cl : cnf.clauses.all())
+			if (cl.color() == Color::blue)
+				clauses.add_clause(cl.lits(), Color::blue);
+		return {std::move(clauses), cnf.var_count()};
+	}
+
+	util::Stopwatch sw;
+	sw.start();
+	int64_t size;
+	auto chunks = parse_chunks(filename, threads, size);
+	merge_chunks(chunks);
+	auto &r = chunks[0];
+	int varCount = check_counts(r);
+	log_parse(r, varCount, size, sw);
+	return {std::move(r.clauses), varCount};
+}
+
+std::pair<ClauseStorage, int> parseCnfFromString(std::string const &content,
+                                                 int threads,
+                                                 size_t min_chunk_size)
+{
+	auto chunks = parse_chunks(
+	    content, threads,
+	    [](CnfChunk &c, std::span<const Lit> cl) {
+		    c.clauses.add_clause(cl, Color::blue);
+	    },
+	    min_chunk_size);
+	merge_chunks(chunks);
+	int varCount = check_counts(chunks[0]);
+	return {std::move(chunks[0].clauses), varCount};
+}
+
+bool parseCnf(std::string filename, Cnf &cnf, int threads)
+{
+	auto file_size = regular_file_size(filename);
+	if (auto info = file_size ? peek_binary_cnf(filename) : std::nullopt)
+	{
+		read_binary_cnf(filename, cnf);
+		return info->has_reconstruction;
+	}
+
+	util::Stopwatch sw;
+	sw.start();
+	int64_t size = 0;
+	CnfChunk r;
+
+	auto compression =
+	    file_size ? detect_compression(filename) : Compression::none;
+	if (compression != Compression::none || !file_size ||
+	    effective_threads(threads, *file_size / (4 << 20)) == 1)
+	{
+		// Common case: the header comes before the first clause, so the
+		// variable count is known and clauses can be added directly without
+		// storing them in between. Otherwise, fall back to temporary storage.
+		bool started = false, direct = false;
+		size = parse_sequential(
+		    filename, compression, r, [&](std::span<const Lit> cl) {
+			    if (!started)
+			    {
+				    started = true;
+				    direct = r.headerVarCount >= 0;
+				    if (direct)
+					    cnf = Cnf(r.headerVarCount);
+			    }
+			    if (!direct)
+			    {
+				    r.clauses.add_clause(cl, Color::blue);
+				    return;
+			    }
+			    for (Lit a : cl)
+				    if (a.var() >= cnf.var_count())
+					    throw std::runtime_error(fmt::format(
+					        "wrong number of variables: header said {}, "
+					        "but found literal {}",
+					        cnf.var_count(), a));
+			    cnf.add_clause_safe(cl);
+		    });
+		if (!direct)
+		{
+			cnf = Cnf(check_counts(r));
+			for (auto &cl : r.clauses.all())
+				cnf.add_clause_safe(cl.lits());
+			r.clauses = {};
+		}
+	}
+	else
+	{
+		// Parse in parallel into temporary storage first. The chunks are
+		// freed one by one while adding to the Cnf to keep the peak memory
+		// low.
+		auto chunks = parse_chunks(filename, threads, size);
+		for (size_t t = 1; t < chunks.size(); ++t)
+			merge_counts(chunks[0], chunks[t]);
+		cnf = Cnf(check_counts(chunks[0]));
+		for (auto &c : chunks)
+		{
+			for (auto &cl : c.clauses.all())
+				cnf.add_clause_safe(cl.lits());
+			c.clauses = {};
+		}
+		r = std::move(chunks[0]);
+	}
+
+	int varCount = check_counts(r);
+	assert(varCount == cnf.var_count());
+	log_parse(r, varCount, size, sw);
+	return false;
+}
+
+bool checkSolution(std::string filename, Assignment const &sol, int threads)
+{
+	if (peek_binary_cnf(filename))
+		return check_binary_solution(filename, sol);
+
+	util::Stopwatch sw;
+	sw.start();
+
+	// failures are rare, so a shared counter is fine
+	std::atomic<int64_t> nFailed = 0;
+	auto check = [&](std::span<const Lit> cl) {
+		for (Lit a : cl)
+			if (a.var() >= sol.var_count())
+				throw std::runtime_error("solution has too few variables");
+		if (!sol.satisfied(cl))
+			++nFailed;
+	};
+
+	CnfChunk r;
+	int64_t size;
+	auto compression = detect_compression(filename);
+	if (compression != Compression::none || filename.empty())
+		size = parse_sequential(filename, compression, r, check);
+	else
+	{
+		auto input = InputBuffer(filename);
+		size = input.view().size();
+		auto chunks = parse_chunks(
+		    input.view(), threads,
+		    [&](CnfChunk &, std::span<const Lit> cl) { check(cl); });
+		r = std::move(chunks[0]);
+		for (size_t t = 1; t < chunks.size(); ++t)
+			merge_counts(r, chunks[t]);
+	}
+	check_counts(r);
+	sw.stop();
+	util::Logger("parser").info("checked {} clauses in {:.2f}s ({:.0f} MiB/s)",
+	                            r.clauseCount, sw.secs(),
+	                            size / 1024. / 1024 / sw.secs());
+	if (nFailed)
+		util::Logger("parser").warning("{} clauses not satisfied",
+		                               nFailed.load());
+	return nFailed == 0;
+}
 
+void parseAssignment(std::string filename, Assignment &sol)
+{
+	parse_solution(filename, [&](Lit lit) {
+		if (lit.var() >= sol.var_count())
+			throw std::runtime_error("invalid literal in solution");
+		sol.set(lit);
+	});
+	if (!sol.complete())
+		throw std::runtime_error("incomplete solution");
+}
+
+Assignment parseAssignment(std::string filename)
+{
+	std::vector<Lit> lits;
+	int varCount = 0;
+	parse_solution(filename, [&](Lit lit) {
+		lits.push_back(lit);
+		varCount = std::max(varCount, lit.var() + 1);
+	});
+	auto sol = Assignment(varCount);
+	for (Lit lit : lits)
+	{
+		if (sol(lit.var()) != lundef)
+			throw std::runtime_error("variable assigned twice in solution");
+		sol.set(lit);
+	}
 	if (!sol.complete())
 		throw std::runtime_error("incomplete solution");
+	return sol;
+}
+
+void writeSolution(std::string const &filename, Assignment const &sol)
+{
+	// owned file is closed automatically if writing fails (stdout is not)
+	struct Closer
+	{
+		void operator()(std::FILE *f) const { std::fclose(f); }
+	};
+	auto owned = std::unique_ptr<std::FILE, Closer>();
+	std::FILE *file = stdout;
+	if (!filename.empty())
+	{
+		owned.reset(std::fopen(filename.c_str(), "w"));
+		if (!owned)
+			throw std::runtime_error(fmt::format(
+			    "could not open '{}': {}", filename, strerror(errno)));
+		file = owned.get();
+	}
+
+	// Literals are formatted by hand into a large buffer. For millions of
+	// variables, this is a lot faster than going through fmt one by one.
+	std::string buf;
+	buf.reserve((1 << 16) + 32);
+	auto flush = [&]() {
+		if (std::fwrite(buf.data(), 1, buf.size(), file) != buf.size())
+			throw std::runtime_error(fmt::format(
+			    "error while writing solution: {}", strerror(errno)));
+		buf.clear();
+	};
+
+	buf += "s SATISFIABLE\nv";
+	char digits[16];
+	for (int i = 0; i < sol.var_count(); ++i)
+	{
+		if (sol(i) == lundef)
+			continue;
+		char *p = digits + sizeof(digits);
+		for (unsigned x = i + 1; x; x /= 10)
+			*--p = char('0' + x % 10);
+		buf += ' ';
+		if (sol(i) == lfalse)
+			buf += '-';
+		buf.append(p, digits + sizeof(digits));
+		if (buf.size() >= (1 << 16))
+			flush();
+	}
+	buf += " 0\n";
+	flush();
+
+	if (!owned)
+		std::fflush(stdout);
+	else if (std::fclose(owned.release()) != 0)
+		throw std::runtime_error(fmt::format("error while writing '{}': {}",
+		                                     filename, strerror(errno)));
 }
 
 } // namespace dawn
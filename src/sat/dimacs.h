@@ -1,13 +1,53 @@
 #pragma once
 
-#include "assignment.h"
-#include "clause.h"
+#include "sat/assignment.h"
+#include "sat/clause.h"
+#include "sat/cnf.h"
 #include <string>
 
 namespace dawn {
 
-/** filename = "" means reading from stdin */
-std::pair<ClauseStorage, int> parseCnf(std::string filename);
+/**
+ * filename = "" means reading from stdin
+ * files in the binary format of 'binary_cnf.h' are detected automatically
+ * threads > 1 tokenizes (large) inputs concurrently (<= 0 means all cores)
+ */
+std::pair<ClauseStorage, int> parseCnf(std::string filename, int threads = 1);
+
+/**
+ * same, but builds the Cnf directly (overwriting 'cnf'), without keeping a
+ * copy of the original clauses around. Returns true if the input was an
+ * already simplified formula (binary CNF including reconstruction).
+ */
+bool parseCnf(std::string filename, Cnf &cnf, int threads = 1);
+
+/**
+ * parse a DIMACS CNF from memory. Chunks of at least 'min_chunk_size' bytes
+ * are tokenized concurrently (tiny chunks are only useful for testing)
+ */
+std::pair<ClauseStorage, int>
+parseCnfFromString(std::string const &content, int threads = 1,
+                   size_t min_chunk_size = 4 << 20);
+
+/**
+ * Re-read a CNF file and check that 'sol' satisfies all clauses. Clauses are
+ * checked one by one while parsing, so this needs (almost) no extra memory.
+ * threads > 1 checks chunks of (large, uncompressed) files concurrently.
+ */
+bool checkSolution(std::string filename, Assignment const &sol,
+                   int threads = 1);
+
+/**
+ * read a solution ('v' lines). The first version requires it to be complete
+ * for the variables of 'sol', the second one takes the number of variables
+ * from the solution itself
+ */
 void parseAssignment(std::string filename, Assignment &sol);
+Assignment parseAssignment(std::string filename);
+
+/**
+ * write 's SATISFIABLE' and a 'v' line for 'sol' (filename = "" means stdout)
+ */
+void writeSolution(std::string const &filename, Assignment const &sol);
 
 } // namespace dawn
@@ -107,6 +107,7 @@ int makeDisjunctions(Cnf &sat)
 		{
 			// check of occurance is still valid
 			auto &cl = sat.clauses[ci];
+			sat.proof_begin_change(cl);
 			if (!cl.remove_litarals(pair.first, pair.second))
 				continue;
 			replaced += 1;
@@ -122,6 +123,7 @@ int makeDisjunctions(Cnf &sat)
 			}
 
 			sat.clauses[ci].add_literal(a);
+			sat.proof_end_change(sat.clauses[ci]);
 
 			// TODO: add new pairs to queue
 		}
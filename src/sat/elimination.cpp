@@ -2,6 +2,7 @@
 
 #include "fmt/format.h"
 #include "sat/clause.h"
+#include "sat/parallel.h"
 #include "sat/propengine.h"
 #include "sat/subsumption.h"
 #include "util/bit_vector.h"
@@ -219,20 +220,44 @@ struct Elimination
 	//   - also does BCE on the fly
 	int compute_score(int v);
 
+	// compute all resolvents of v. Does not modify anything, so it can be
+	// run concurrently for independent variables.
+	void resolve(int v, ClauseStorage &resolvents);
+
 	// eliminate a variable: add resolvents, move clauses to extender
-	void eliminate(int v);
+	void eliminate(int v, ClauseStorage &resolvents);
+	void eliminate(int v)
+	{
+		ClauseStorage resolvents;
+		resolve(v, resolvents);
+		eliminate(v, resolvents);
+	}
+
+	// mark all variables whose score changes when eliminating v
+	void mark_dirty(int v);
 
 	// find best variable to eliminate next.
 	// returns -1 if no more candidates are available.
 	int choose_var();
 
-	// returns number of removed variables
+	// choose a batch of variables with pairwise disjoint neighbourhoods.
+	// candidates that conflict with the batch are put back into the queue.
+	std::vector<int> choose_batch(size_t max_size);
+
+	// main loop, one variable at a time
 	void run();
+
+	// main loop, multiple independent variables at a time
+	void run_batched(int threads);
+
+	// final cleanup and statistics
+	void finish();
 };
 
 int Elimination::compute_score(int v)
 {
-	if (eliminated[v])
+	// frozen variables are neither eliminated nor used as pivot for BCE
+	if (eliminated[v] || cnf.is_frozen(v))
 		return score_never;
 
 	// eliminating fixed variables would break our implementation.
@@ -285,6 +310,8 @@ int Elimination::compute_score(int v)
 			for (Lit x : cl)
 				dirty.add(x.var());
 			cnf.add_rule(cl, pos);
+			if (blocked_color == Color::black)
+				cnf.proof_delete(cl.lits());
 			cl.set_color(blocked_color);
 		}
 	for (int j = 0; j < (int)occs[neg].size(); ++j)
@@ -296,6 +323,8 @@ int Elimination::compute_score(int v)
 			for (Lit x : cl)
 				dirty.add(x.var());
 			cnf.add_rule(cl, neg);
+			if (blocked_color == Color::black)
+				cnf.proof_delete(cl.lits());
 			cl.set_color(blocked_color);
 		}
 
@@ -313,27 +342,12 @@ int Elimination::compute_score(int v)
 	return score;
 }
 
-// eliminate a variable: add resolvents, move clauses to extender
-void Elimination::eliminate(int v)
+void Elimination::resolve(int v, ClauseStorage &resolvents)
 {
-	assert(!eliminated[v]);
-	eliminated[v] = true;
-	++nEliminated;
-
-	// I think this might happen in a very contrived case?
-	for (Lit a : cnf.units)
-		if (a.var() == v)
-			throw std::runtime_error("eliminating fixed variable");
-
 	auto pos = Lit(v, false);
 	auto neg = Lit(v, true);
 
-	log.debug("eliminating variable {} ({}+{} bins, {}+{} occs)", pos,
-	          cnf.bins[pos].size(), cnf.bins[neg].size(), occs[pos].size(),
-	          occs[neg].size());
-
 	std::vector<Lit> tmp;
-	ClauseStorage resolvents;
 
 	// add binary-binary resolvents
 	for (Lit x : cnf.bins[pos])
@@ -362,18 +376,46 @@ void Elimination::eliminate(int v)
 		for (Clause const &b : occs_all(neg))
 			if (resolvent(tmp, a.lits(), b.lits()))
 				resolvents.add_clause(tmp, min(a.color(), b.color()));
+}
+
+// eliminate a variable: add resolvents, move clauses to extender
+void Elimination::eliminate(int v, ClauseStorage &resolvents)
+{
+	assert(!eliminated[v]);
+	eliminated[v] = true;
+	++nEliminated;
+
+	// I think this might happen in a very contrived case?
+	for (Lit a : cnf.units)
+		if (a.var() == v)
+			throw std::runtime_error("eliminating fixed variable");
+
+	auto pos = Lit(v, false);
+	auto neg = Lit(v, true);
+
+	log.debug("eliminating variable {} ({}+{} bins, {}+{} occs)", pos,
+	          cnf.bins[pos].size(), cnf.bins[neg].size(), occs[pos].size(),
+	          occs[neg].size());
+
+	// removed clauses can only be deleted from the proof after the resolvents
+	// (which are derived from them) have been added
+	ClauseStorage removed;
 
 	// remove old long clauses from the problem
 	for (Clause &a : occs_all(pos))
 	{
 		if (a.color() == Color::blue)
 			cnf.add_rule(a, pos);
+		if (cnf.proof)
+			removed.add_clause(a.lits(), Color::blue);
 		a.set_color(Color::black);
 	}
 	for (Clause &a : occs_all(neg))
 	{
 		if (a.color() == Color::blue)
 			cnf.add_rule(a, neg);
+		if (cnf.proof)
+			removed.add_clause(a.lits(), Color::blue);
 		a.set_color(Color::black);
 	}
 
@@ -382,11 +424,15 @@ void Elimination::eliminate(int v)
 	{
 		erase(cnf.bins[b], pos);
 		cnf.add_rule({{pos, b}});
+		if (cnf.proof)
+			removed.add_binary(pos, b);
 	}
 	for (Lit b : cnf.bins[neg])
 	{
 		erase(cnf.bins[b], neg);
 		cnf.add_rule({{neg, b}});
+		if (cnf.proof)
+			removed.add_binary(neg, b);
 	}
 	cnf.bins[pos].resize(0);
 	cnf.bins[neg].resize(0);
@@ -398,6 +444,8 @@ void Elimination::eliminate(int v)
 		if (add_clause(cl))
 			++resolvent_count;
 	nResolvents += resolvent_count;
+	for (Clause const &cl : removed.all())
+		cnf.proof_delete(cl.lits());
 
 	log.debug("eliminated variable {}, adding {} resolvents", pos,
 	          resolvent_count);
@@ -447,29 +495,132 @@ void Elimination::run()
 		// considered irreducible (like all binaries), affecting the score.
 		assert(score[v] == compute_score(v));
 
-		auto pos = Lit(v, false);
-		auto neg = Lit(v, true);
-
 		// determine other variables whose score will have to be
 		// recalculated
-		for (Lit x : cnf.bins[pos])
-			dirty.add(x.var());
-		for (Lit x : cnf.bins[neg])
-			dirty.add(x.var());
-		for (CRef k : occs[pos])
-			if (cnf.clauses[k].color() == Color::blue)
-				for (Lit x : cnf.clauses[k].lits())
-					dirty.add(x.var());
-		for (CRef k : occs[neg])
-			if (cnf.clauses[k].color() == Color::blue)
-				for (Lit x : cnf.clauses[k].lits())
-					dirty.add(x.var());
+		mark_dirty(v);
 
 		// eliminate the variable
 		eliminate(v);
 		score[v] = score_never;
 	}
 
+	finish();
+}
+
+void Elimination::run_batched(int threads)
+{
+	for (int i : cnf.all_vars())
+		dirty.add(i);
+
+	// Only a few variables per batch would already be enough to keep all
+	// threads busy. But larger batches amortize the (serial) rescoring.
+	// Fixed instead of scaled by 'threads', so that the result does not
+	// depend on the number of threads (or the machine, for 'threads = 0').
+	constexpr size_t batch_size = 512;
+	std::vector<ClauseStorage> resolvents;
+	int64_t nBatches = 0;
+
+	while (nEliminated < config.max_eliminations &&
+	       nResolvents < config.max_resolvents)
+	{
+		auto batch = choose_batch(batch_size);
+		if (batch.empty())
+			break;
+		++nBatches;
+
+		// compute resolvents concurrently. Variables in a batch do not share
+		// any clauses, so this only reads disjoint parts of the formula.
+		resolvents.resize(0);
+		resolvents.resize(batch.size());
+		run_parallel(threads, [&](int t) {
+			for (size_t i = t; i < batch.size(); i += threads)
+				resolve(batch[i], resolvents[i]);
+		});
+
+		// commit serially, in the order the variables were chosen. Variables
+		// that did not make it due to the limits keep their (valid) score.
+		for (size_t i = 0; i < batch.size(); ++i)
+		{
+			int v = batch[i];
+			if (nEliminated >= config.max_eliminations ||
+			    nResolvents >= config.max_resolvents)
+			{
+				queue.push({score[v], v});
+				continue;
+			}
+			mark_dirty(v);
+			eliminate(v, resolvents[i]);
+			score[v] = score_never;
+		}
+	}
+
+	log.info("eliminated in {} batches using {} threads", nBatches, threads);
+	finish();
+}
+
+void Elimination::mark_dirty(int v)
+{
+	auto pos = Lit(v, false);
+	auto neg = Lit(v, true);
+	for (Lit x : cnf.bins[pos])
+		dirty.add(x.var());
+	for (Lit x : cnf.bins[neg])
+		dirty.add(x.var());
+	for (CRef k : occs[pos])
+		if (cnf.clauses[k].color() == Color::blue)
+			for (Lit x : cnf.clauses[k].lits())
+				dirty.add(x.var());
+	for (CRef k : occs[neg])
+		if (cnf.clauses[k].color() == Color::blue)
+			for (Lit x : cnf.clauses[k].lits())
+				dirty.add(x.var());
+}
+
+std::vector<int> Elimination::choose_batch(size_t max_size)
+{
+	std::vector<int> batch;
+	std::vector<int> rejected;
+	auto taken = util::bit_vector(cnf.var_count());
+	std::vector<int> nbhd;
+
+	// Late in the process, most candidates tend to conflict with each other.
+	// Limit the number of rejections to avoid quadratic runtime.
+	while (batch.size() < max_size && rejected.size() < 4 * max_size)
+	{
+		int v = choose_var();
+		if (v == -1)
+			break;
+		assert(score[v] == compute_score(v));
+
+		// closed neighbourhood of v, i.e., all variables sharing a
+		// (non-removed) clause with v
+		nbhd.assign({v});
+		for (Lit a : {Lit(v, false), Lit(v, true)})
+		{
+			for (Lit x : cnf.bins[a])
+				nbhd.push_back(x.var());
+			for (Clause const &cl : occs_all(a))
+				for (Lit x : cl.lits())
+					nbhd.push_back(x.var());
+		}
+
+		if (std::ranges::any_of(nbhd, [&](int w) { return taken[w]; }))
+		{
+			rejected.push_back(v);
+			continue;
+		}
+		for (int w : nbhd)
+			taken[w] = true;
+		batch.push_back(v);
+	}
+
+	for (int v : rejected)
+		queue.push({score[v], v});
+	return batch;
+}
+
+void Elimination::finish()
+{
 	// remove reducible clauses that contain eliminated variables
 	for (auto &cl : cnf.clauses.all())
 	{
@@ -478,6 +629,7 @@ void Elimination::run()
 		if (elim)
 		{
 			assert(cl.color() != Color::blue);
+			cnf.proof_delete(cl.lits());
 			cl.set_color(Color::black);
 		}
 	}
@@ -495,7 +647,11 @@ int run_elimination(Cnf &sat, EliminationConfig const &config)
 	// assert(is_normal_form(sat)); // not strictly necessary
 
 	auto elim = Elimination(sat, config);
-	elim.run();
+	if (int threads = effective_threads(config.threads, sat.var_count());
+	    threads > 1)
+		elim.run_batched(threads);
+	else
+		elim.run();
 
 	// renumber (inner variables cant stay in eliminated state)
 	std::vector<Lit> trans(sat.var_count());
@@ -558,7 +714,7 @@ int run_blocked_clause_addition(Cnf &sat)
 		{
 			if (p.assign[b] || p.assign[b.neg()])
 				continue;
-			if (seen[b])
+			if (seen[b] || sat.is_frozen(b.var()))
 				continue;
 
 			for (Lit x : sat.bins[b])
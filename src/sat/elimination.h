@@ -40,6 +40,15 @@ struct EliminationConfig
 	//   * reducible resolvents are counted towards this limit (assuming they
 	//     pass the '.green_cutoff' limit)
 	int64_t max_resolvents = 20'000;
+
+	// Number of threads (<= 0 means all cores). With more than one thread,
+	// variables are eliminated in batches: a batch consists of variables with
+	// pairwise disjoint (closed) neighbourhoods, so that their resolvents can
+	// be computed concurrently. Resolvents are then committed serially in the
+	// order the variables were chosen. The order of eliminations differs
+	// slightly from the single-threaded one, but is the same for any number
+	// of threads > 1 (batches have a fixed size).
+	int threads = 1;
 };
 
 // returns number of removed variables
@@ -0,0 +1,237 @@
+#include "sat/incremental.h"
+
+#include "fmt/format.h"
+#include <algorithm>
+#include <climits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace dawn {
+
+IncrementalSolver::IncrementalSolver(SolverConfig const &config)
+    : config_(config)
+{}
+
+IncrementalSolver::IncrementalSolver(Cnf sat, SolverConfig const &config)
+    : sat_(std::move(sat)), config_(config)
+{
+	auto const &rec = sat_.reconstruction();
+	if (rec.rule_count() != 0 || !sat_.external.empty())
+		throw std::runtime_error("formula is already preprocessed");
+
+	int n = rec.orig_var_count();
+	sat_.external.assign(n, Lit::undef());
+	for (int i = 0; i < sat_.var_count(); ++i)
+	{
+		Lit a = rec.outer(Lit(i, false));
+		assert(a.var() < n);
+		sat_.external[a.var()] = Lit(i, a.sign());
+	}
+	if (std::ranges::find(sat_.external, Lit::undef()) != sat_.external.end())
+		throw std::runtime_error("formula is already preprocessed");
+
+	for (int v = 0; v < n; ++v)
+		outer_.push_back(Lit(v, false));
+	frozen_.assign(n, 0);
+	locked_.assign(n, 0);
+}
+
+void IncrementalSolver::check_var(int v) const
+{
+	if (v < 0 || v >= var_count())
+		throw std::runtime_error(fmt::format("unknown variable {}", v + 1));
+	if (locked_[v])
+		throw std::runtime_error(fmt::format(
+		    "variable {} was not frozen during preprocessing", v + 1));
+}
+
+int IncrementalSolver::add_var()
+{
+	int v = sat_.add_var();
+	sat_.external.push_back(Lit(v, false));
+	outer_.push_back(sat_.reconstruction().outer(Lit(v, false)));
+	frozen_.push_back(0);
+	locked_.push_back(0);
+	return var_count() - 1;
+}
+
+void IncrementalSolver::add_clause(std::span<const Lit> lits)
+{
+	std::vector<Lit> buf;
+	for (Lit a : lits)
+	{
+		check_var(a.var());
+		buf.push_back(sat_.external[a.var()] ^ a.sign());
+	}
+
+	// after a contradiction, external variables are all eliminated
+	if (!sat_.contradiction)
+		sat_.add_clause_safe(buf);
+}
+
+void IncrementalSolver::add_xor(std::span<const Lit> lits, bool rhs)
+{
+	std::vector<Lit> buf;
+	for (Lit a : lits)
+	{
+		check_var(a.var());
+		buf.push_back(sat_.external[a.var()] ^ a.sign());
+	}
+	if (!sat_.contradiction)
+		sat_.add_xor_safe(buf, rhs);
+}
+
+void IncrementalSolver::assume(Lit a)
+{
+	check_var(a.var());
+	assumptions_.push_back(a);
+}
+
+void IncrementalSolver::freeze(int v)
+{
+	check_var(v);
+	frozen_[v] += 1;
+	if (Lit a = sat_.external[v]; a.proper())
+		sat_.freeze(a.var());
+}
+
+void IncrementalSolver::melt(int v)
+{
+	check_var(v);
+	if (frozen_[v] == 0)
+		throw std::runtime_error(
+		    fmt::format("variable {} is not frozen", v + 1));
+	frozen_[v] -= 1;
+
+	// fixed variables lost their count already
+	if (Lit a = sat_.external[v]; a.proper())
+		sat_.melt(a.var());
+}
+
+void IncrementalSolver::set_terminate(std::function<bool()> f)
+{
+	callbacks_.terminate = std::move(f);
+}
+
+void IncrementalSolver::set_learn(
+    int max_size, std::function<void(std::span<const Lit>)> f)
+{
+	callbacks_.learn = std::move(f);
+	callbacks_.learn_max_size = max_size;
+	callbacks_.learn_max_lbd = INT_MAX;
+}
+
+void IncrementalSolver::set_export(ClauseExport *e)
+{
+	if (!e)
+	{
+		set_learn(0, {});
+		return;
+	}
+	callbacks_.learn = [e](std::span<const Lit> cl) { e->push(cl); };
+	callbacks_.learn_max_size = e->config().max_size;
+	callbacks_.learn_max_lbd = e->config().max_lbd;
+}
+
+int IncrementalSolver::run(SolverCallbacks const &callbacks,
+                           std::stop_token stoken)
+{
+	auto config = config_;
+	config.preprocess = config_.preprocess && !preprocessed_;
+	int r = dawn::solve(sat_, model_, config, stoken, assumptions_, &failed_,
+	                    callbacks);
+
+	// Unfrozen variables might be eliminated by now, or might have been used
+	// as pivot for blocked clauses. Either way, they can not be used anymore.
+	if (config.preprocess)
+	{
+		preprocessed_ = true;
+		for (int v = 0; v < var_count(); ++v)
+			if (frozen_[v] == 0 && !sat_.external[v].fixed())
+				locked_[v] = 1;
+	}
+	return r;
+}
+
+int IncrementalSolver::solve(std::stop_token stoken)
+{
+	// assumptions have to survive preprocessing
+	for (Lit a : assumptions_)
+		freeze(a.var());
+
+	result_ = run(callbacks_, stoken);
+
+	for (Lit a : assumptions_)
+		melt(a.var());
+	assumptions_.clear();
+	return result_;
+}
+
+int IncrementalSolver::enumerate(std::span<const int> projection,
+                                 std::function<bool()> f,
+                                 std::stop_token stoken)
+{
+	std::vector<int> all;
+	if (projection.empty())
+	{
+		all.resize(var_count());
+		std::iota(all.begin(), all.end(), 0);
+		projection = all;
+	}
+
+	// Validate all of the projection before freezing any of it, so that an
+	// invalid variable does not leave the others frozen. Assumptions are
+	// cleared in any case.
+	try
+	{
+		for (int v : projection)
+			check_var(v);
+	}
+	catch (...)
+	{
+		assumptions_.clear();
+		throw;
+	}
+
+	// projection variables have to survive preprocessing. Others may be
+	// eliminated, as that does not change the projected solutions.
+	for (int v : projection)
+		freeze(v);
+	for (Lit a : assumptions_)
+		freeze(a.var());
+
+	auto callbacks = callbacks_;
+	callbacks.projection = projection;
+	callbacks.on_model = [&](Assignment const &a) {
+		model_ = a;
+		result_ = 10;
+		return f();
+	};
+	result_ = run(callbacks, stoken);
+
+	for (int v : projection)
+		melt(v);
+	for (Lit a : assumptions_)
+		melt(a.var());
+	assumptions_.clear();
+	return result_;
+}
+
+lbool IncrementalSolver::value(Lit a) const
+{
+	assert(result_ == 10);
+	assert(a.var() < var_count());
+	Lit b = outer_[a.var()] ^ a.sign();
+	if (b.var() >= model_.var_count())
+		return lundef;
+	return model_(b);
+}
+
+bool IncrementalSolver::failed(Lit a) const
+{
+	assert(result_ == 20);
+	return std::ranges::find(failed_, a) != failed_.end();
+}
+
+} // namespace dawn
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "sat/assignment.h"
+#include "sat/clause_export.h"
+#include "sat/cnf.h"
+#include "sat/solver.h"
+#include "sat/stats.h"
+#include <cstdint>
+#include <span>
+#include <stop_token>
+#include <vector>
+
+namespace dawn {
+
+// Incremental interface to 'solve()', for sequences of related queries
+//   * clauses can be added between calls to 'solve'. Learnt clauses and the
+//     result of preprocessing are kept.
+//   * assumptions only hold for the next call to 'solve'. If that returns
+//     UNSAT, 'failed' tells which of them were used in the refutation.
+//   * literals use 'external' variables, numbered in order of creation and
+//     unaffected by the renumbering done internally
+//   * preprocessing (only done in the first call) may eliminate variables,
+//     after which they can not be used anymore. Variables that are needed
+//     later have to be frozen before that. Variables created after the first
+//     call can always be used.
+//   * 'enumerate' finds all solutions (possibly projected) in a single
+//     search, i.e., without restarting the solver for each of them
+//   * copies are independent, e.g., for running different queries starting
+//     from the same preprocessed formula
+class IncrementalSolver
+{
+	Cnf sat_;
+	SolverConfig config_;
+	SolverCallbacks callbacks_;
+	std::vector<Lit> outer_;      // outer literal of each external variable
+	std::vector<int> frozen_;     // freeze count of each external variable
+	std::vector<uint8_t> locked_; // possibly removed by preprocessing
+	bool preprocessed_ = false;
+
+	std::vector<Lit> assumptions_, failed_;
+	Assignment model_;
+	int result_ = 0;
+
+	// throws if 'v' can not be used in clauses or assumptions (anymore)
+	void check_var(int v) const;
+
+	// 'dawn::solve' with the current assumptions, preprocessing if not done
+	// yet. Does not touch 'result_'.
+	int run(SolverCallbacks const &callbacks, std::stop_token stoken);
+
+  public:
+	explicit IncrementalSolver(SolverConfig const &config = {});
+
+	// start from an existing formula. External variables are its original
+	// ones, so it must not be preprocessed yet (renumbering is fine).
+	explicit IncrementalSolver(Cnf sat, SolverConfig const &config = {});
+
+	// add a new variable, returns its (external) number
+	int add_var();
+	int var_count() const { return (int)outer_.size(); }
+
+	// add a clause (not normalized yet, i.e., duplicate literals are fine)
+	void add_clause(std::span<const Lit> lits);
+
+	// add XOR constraint 'lits[0] ^ lits[1] ^ ... = rhs' (see 'XorClause')
+	void add_xor(std::span<const Lit> lits, bool rhs);
+
+	// add an assumption for the next call to 'solve'
+	void assume(Lit a);
+
+	// protect a variable from elimination (see 'Cnf::freeze')
+	void freeze(int v);
+	void melt(int v);
+
+	// callbacks for all future calls to 'solve' (see 'SolverCallbacks')
+	void set_terminate(std::function<bool()> f);
+	void set_learn(int max_size, std::function<void(std::span<const Lit>)> f);
+
+	// asynchronous alternative to 'set_learn', using the size and LBD limits
+	// of the export (not owned, nullptr to disable)
+	void set_export(ClauseExport *e);
+
+	// returns 10=SAT, 20=UNSAT, 30=UNKNOWN. Clears all assumptions.
+	int solve(std::stop_token stoken = {});
+
+	// Enumerate solutions, calling 'f' for each of them. 'value' can be used
+	// inside of 'f', returning false stops the enumeration.
+	//   * with a projection (external variables), solutions which only differ
+	//     outside of it count as one. Otherwise all variables have to be
+	//     usable (see 'check_var'), which is true before the first 'solve'.
+	//   * found solutions are blocked permanently, so a later call continues
+	//     with the remaining ones. With assumptions, they are only blocked
+	//     under those assumptions (which are cleared afterwards).
+	//   * returns 20 if all solutions were found, 30 if stopped early
+	int enumerate(std::span<const int> projection, std::function<bool()> f,
+	              std::stop_token stoken = {});
+
+	// value of a literal in the solution (only valid after SAT, or during
+	// enumeration). Variables created after the last 'solve' are unassigned.
+	lbool value(Lit a) const;
+
+	// true if assumption 'a' was used to show UNSAT (only valid after UNSAT)
+	bool failed(Lit a) const;
+	std::span<const Lit> failed() const { return failed_; }
+};
+
+} // namespace dawn
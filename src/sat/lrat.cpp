@@ -0,0 +1,574 @@
+#include "sat/lrat.h"
+
+#include "fmt/format.h"
+#include "sat/proof_format.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace dawn {
+
+LratBuilder::LratBuilder(ClauseStorage const &original, bool binary)
+    : next_id_(1), binary_(binary)
+{
+	for (auto &cl : original.all())
+		insert(next_id_++, cl.lits());
+}
+
+void LratBuilder::ensure_var(Lit a)
+{
+	assert(a.proper());
+	if ((size_t)a.var() < reason_.size())
+		return;
+	size_t n = a.var() + 1;
+	value_.resize(2 * n);
+	check_.resize(2 * n);
+	watches_.resize(2 * n);
+	reason_.resize(n);
+	trail_pos_.resize(n);
+	unit_.resize(n);
+	seen_.resize(n);
+	in_lemma_.resize(n);
+}
+
+bool LratBuilder::assigned(int v) const
+{
+	return value_[Lit(v, false)] || value_[Lit(v, true)];
+}
+
+void LratBuilder::assign(Lit a, Entry *reason)
+{
+	assert(!value_[a] && !value_[a.neg()]);
+	value_[a] = 1;
+	reason_[a.var()] = reason;
+	trail_pos_[a.var()] = trail_.size();
+	trail_.push_back(a);
+}
+
+LratBuilder::Entry *LratBuilder::propagate()
+{
+	while (qhead_ < trail_.size())
+	{
+		Lit x = trail_[qhead_++];
+		auto &ws = watches_[x.neg()];
+		size_t j = 0;
+		for (size_t i = 0; i < ws.size(); ++i)
+		{
+			Entry *e = ws[i];
+			auto &c = e->lits;
+			if (c[0] == x.neg())
+				std::swap(c[0], c[1]);
+			assert(c[1] == x.neg());
+
+			if (value_[c[0]])
+			{
+				ws[j++] = e;
+				continue;
+			}
+
+			// look for a new watch
+			bool moved = false;
+			for (size_t k = 2; k < c.size(); ++k)
+				if (!value_[c[k].neg()])
+				{
+					std::swap(c[1], c[k]);
+					watches_[c[1]].push_back(e);
+					moved = true;
+					break;
+				}
+			if (moved)
+				continue;
+
+			ws[j++] = e;
+			if (value_[c[0].neg()])
+			{
+				for (++i; i < ws.size(); ++i)
+					ws[j++] = ws[i];
+				ws.resize(j);
+				qhead_ = trail_.size();
+				return e;
+			}
+			assign(c[0], e);
+		}
+		ws.resize(j);
+	}
+	return nullptr;
+}
+
+void LratBuilder::backtrack()
+{
+	while (trail_.size() > top_)
+	{
+		Lit a = trail_.back();
+		trail_.pop_back();
+		value_[a] = 0;
+		reason_[a.var()] = nullptr;
+	}
+	qhead_ = top_;
+}
+
+LratBuilder::Entry *LratBuilder::find(std::span<const Lit> lits)
+{
+	tmp_.assign(lits.begin(), lits.end());
+	std::sort(tmp_.begin(), tmp_.end());
+	tmp_.erase(std::unique(tmp_.begin(), tmp_.end()), tmp_.end());
+	for (Lit a : tmp_)
+		if ((size_t)a.var() >= reason_.size())
+			return nullptr;
+
+	Entry *r = nullptr;
+	auto [first, last] = index_.equal_range(clause_hash(tmp_));
+	if (first == last)
+		return nullptr;
+	for (Lit a : tmp_)
+		check_[a] = 1;
+	for (auto it = first; it != last && !r; ++it)
+	{
+		Entry &e = clauses_.at(it->second);
+		if (e.lits.size() == tmp_.size() &&
+		    std::all_of(e.lits.begin(), e.lits.end(),
+		                [&](Lit a) { return check_[a] != 0; }))
+			r = &e;
+	}
+	for (Lit a : tmp_)
+		check_[a] = 0;
+	return r;
+}
+
+LratBuilder::Entry &LratBuilder::insert(uint64_t id,
+                                        std::span<const Lit> lits)
+{
+	for (Lit a : lits)
+		ensure_var(a);
+	auto c = std::vector<Lit>(lits.begin(), lits.end());
+	std::sort(c.begin(), c.end());
+	c.erase(std::unique(c.begin(), c.end()), c.end());
+	bool tautology = false;
+	for (size_t i = 1; i < c.size(); ++i)
+		if (c[i] == c[i - 1].neg())
+			tautology = true;
+
+	index_.emplace(clause_hash(c), id);
+	auto &e = clauses_.emplace(id, Entry{id, std::move(c)}).first->second;
+	if (!tautology && !conflict_)
+		attach(e);
+	return e;
+}
+
+void LratBuilder::attach(Entry &e)
+{
+	assert(trail_.size() == top_);
+	auto &c = e.lits;
+
+	// true literals first, then unassigned, then false
+	auto rank = [&](Lit a) { return value_[a] ? 0 : value_[a.neg()] ? 2 : 1; };
+	std::stable_sort(c.begin(), c.end(),
+	                 [&](Lit a, Lit b) { return rank(a) < rank(b); });
+
+	if (c.empty() || value_[c[0].neg()])
+	{
+		conflict_ = &e;
+		return;
+	}
+
+	if (c.size() == 1)
+	{
+		if (!value_[c[0]])
+			assign(c[0], &e);
+		if (!unit_[c[0].var()])
+			unit_[c[0].var()] = e.id;
+	}
+	else
+	{
+		watches_[c[0]].push_back(&e);
+		watches_[c[1]].push_back(&e);
+		e.attached = true;
+		if (!value_[c[0]] && value_[c[1].neg()])
+			assign(c[0], &e);
+	}
+
+	conflict_ = propagate();
+	top_ = trail_.size();
+}
+
+void LratBuilder::remove(Entry &e)
+{
+	if (e.attached)
+		for (int k : {0, 1})
+			std::erase(watches_[e.lits[k]], &e);
+
+	auto [first, last] = index_.equal_range(clause_hash(e.lits));
+	for (auto it = first; it != last; ++it)
+		if (it->second == e.id)
+		{
+			index_.erase(it);
+			break;
+		}
+	clauses_.erase(e.id);
+}
+
+uint64_t LratBuilder::unit_id(int v)
+{
+	assert(assigned(v) && trail_pos_[v] < top_);
+	if (unit_[v])
+		return unit_[v];
+
+	// collect all top-level variables without a unit clause this depends on
+	std::vector<int> todo = {v}, order;
+	seen_[v] = 1;
+	while (!todo.empty())
+	{
+		int w = todo.back();
+		todo.pop_back();
+		order.push_back(w);
+		assert(reason_[w]);
+		for (Lit a : reason_[w]->lits)
+			if (a.var() != w && !unit_[a.var()] && !seen_[a.var()])
+			{
+				seen_[a.var()] = 1;
+				todo.push_back(a.var());
+			}
+	}
+
+	// derive them in order of the trail
+	std::sort(order.begin(), order.end(),
+	          [&](int a, int b) { return trail_pos_[a] < trail_pos_[b]; });
+	std::vector<int64_t> hints;
+	for (int w : order)
+	{
+		seen_[w] = 0;
+		Entry *r = reason_[w];
+		hints.clear();
+		for (Lit a : r->lits)
+			if (a.var() != w)
+				hints.push_back(unit_[a.var()]);
+		hints.push_back(r->id);
+
+		auto unit = std::array{Lit(w, value_[Lit(w, true)] != 0)};
+		uint64_t id = next_id_++;
+		write_add(id, unit, hints);
+		insert(id, unit);
+		unit_[w] = id;
+	}
+	return unit_[v];
+}
+
+void LratBuilder::explain(Entry *confl, std::span<const Lit> assumptions)
+{
+	for (Lit a : assumptions)
+		in_lemma_[a.var()] = 1;
+
+	std::vector<int> top_vars;
+	size_t pending = 0;
+	auto handle = [&](Lit a) {
+		int v = a.var();
+		if (seen_[v] || in_lemma_[v])
+			return;
+		seen_[v] = 1;
+		touched_.push_back(v);
+		if (trail_pos_[v] < top_)
+			top_vars.push_back(v);
+		else
+			++pending;
+	};
+
+	// walk the (temporary part of) the trail backwards, collecting reasons
+	used_.clear();
+	for (Lit a : confl->lits)
+		handle(a);
+	for (size_t i = trail_.size(); pending;)
+	{
+		Lit a = trail_[--i];
+		assert(i >= top_);
+		if (!seen_[a.var()])
+			continue;
+		--pending;
+		Entry *r = reason_[a.var()];
+		assert(r);
+		used_.push_back(r);
+		for (Lit b : r->lits)
+			if (b.var() != a.var())
+				handle(b);
+	}
+	uint64_t confl_id = confl->id;
+
+	for (int v : touched_)
+		seen_[v] = 0;
+	touched_.clear();
+	for (Lit a : assumptions)
+		in_lemma_[a.var()] = 0;
+	backtrack();
+
+	hints_.clear();
+	for (int v : top_vars)
+		hints_.push_back(unit_id(v));
+	for (size_t i = used_.size(); i--;)
+		hints_.push_back(used_[i]->id);
+	hints_.push_back(confl_id);
+}
+
+bool LratBuilder::check(std::span<const Lit> lemma)
+{
+	// replays the hints like an LRAT checker would, dropping superfluous ones
+	bool ok = false;
+	checked_.clear();
+	for (Lit a : lemma)
+	{
+		if (check_[a])
+			ok = true; // tautology
+		if (!check_[a.neg()])
+		{
+			check_[a.neg()] = 1;
+			checked_.push_back(a.neg());
+		}
+	}
+
+	size_t j = 0;
+	for (size_t i = 0; i < hints_.size() && !ok; ++i)
+	{
+		auto it = clauses_.find(hints_[i]);
+		if (it == clauses_.end())
+			break;
+		Lit unit = Lit::undef();
+		int unassigned = 0;
+		bool satisfied = false;
+		for (Lit a : it->second.lits)
+			if (check_[a])
+				satisfied = true;
+			else if (!check_[a.neg()])
+			{
+				unit = a;
+				++unassigned;
+			}
+		if (satisfied)
+			continue;
+		if (unassigned > 1)
+			break;
+		hints_[j++] = hints_[i];
+		if (unassigned == 0)
+			ok = true;
+		else
+		{
+			check_[unit] = 1;
+			checked_.push_back(unit);
+		}
+	}
+	hints_.resize(ok ? j : 0);
+
+	for (Lit a : checked_)
+		check_[a] = 0;
+	return ok;
+}
+
+bool LratBuilder::rup(std::span<const Lit> lemma)
+{
+	assert(trail_.size() == top_ && !conflict_);
+	for (Lit a : lemma)
+		ensure_var(a);
+
+	// satisfied at top-level
+	for (Lit a : lemma)
+		if (value_[a])
+		{
+			hints_.assign(1, unit_id(a.var()));
+			return true;
+		}
+
+	for (Lit a : lemma)
+	{
+		if (value_[a]) // tautology
+		{
+			backtrack();
+			hints_.clear();
+			return true;
+		}
+		if (!value_[a.neg()])
+			assign(a.neg(), nullptr);
+	}
+
+	Entry *confl = propagate();
+	if (!confl)
+	{
+		backtrack();
+		return false;
+	}
+	explain(confl, lemma);
+	return true;
+}
+
+bool LratBuilder::rat(std::span<const Lit> lemma)
+{
+	if (lemma.empty())
+		return false;
+	Lit p = lemma[0];
+
+	std::vector<Entry *> candidates;
+	for (auto &[id, e] : clauses_)
+		if (std::find(e.lits.begin(), e.lits.end(), p.neg()) != e.lits.end())
+			candidates.push_back(&e);
+	std::sort(candidates.begin(), candidates.end(),
+	          [](Entry *a, Entry *b) { return a->id < b->id; });
+
+	std::vector<int64_t> hints;
+	std::vector<Lit> resolvent;
+	for (Entry *e : candidates)
+	{
+		resolvent.assign(lemma.begin(), lemma.end());
+		for (Lit a : e->lits)
+			if (a != p.neg())
+				resolvent.push_back(a);
+		std::sort(resolvent.begin(), resolvent.end());
+		bool tautology = false;
+		for (size_t i = 1; i < resolvent.size(); ++i)
+			if (resolvent[i] == resolvent[i - 1].neg())
+				tautology = true;
+		if (tautology)
+			continue;
+
+		if (!rup(resolvent) || !check(resolvent))
+			return false;
+		hints.push_back(-(int64_t)e->id);
+		hints.insert(hints.end(), hints_.begin(), hints_.end());
+	}
+	hints_ = std::move(hints);
+	return true;
+}
+
+void LratBuilder::add(std::string &out, std::span<const Lit> lemma,
+                      std::span<const Lit> chain)
+{
+	if (done_)
+		return;
+	out_ = &out;
+	for (Lit a : lemma)
+		ensure_var(a);
+
+	bool ok = false;
+	if (conflict_)
+	{
+		hints_.clear();
+		for (Lit a : conflict_->lits)
+			hints_.push_back(unit_id(a.var()));
+		hints_.push_back(conflict_->id);
+		ok = check(lemma);
+	}
+	else if (!chain.empty())
+	{
+		// look up the antecedents, which does not include top-level units
+		used_.clear();
+		for (auto it = chain.begin(); it != chain.end();)
+		{
+			auto end = std::find(it, chain.end(), Lit::undef());
+			Entry *e = find(std::span(it, end));
+			if (!e)
+				break;
+			used_.push_back(e);
+			it = end == chain.end() ? end : end + 1;
+		}
+		if (used_.size() == (size_t)std::count(chain.begin(), chain.end(),
+		                                       Lit::undef()))
+		{
+			for (Lit a : lemma)
+				in_lemma_[a.var()] = 1;
+			std::vector<int> top_vars;
+			for (Entry *e : used_)
+				for (Lit a : e->lits)
+				{
+					int v = a.var();
+					if (!seen_[v] && !in_lemma_[v] && assigned(v))
+					{
+						seen_[v] = 1;
+						top_vars.push_back(v);
+					}
+				}
+			for (Lit a : lemma)
+				in_lemma_[a.var()] = 0;
+			for (int v : top_vars)
+				seen_[v] = 0;
+
+			auto ids = std::vector<uint64_t>();
+			for (Entry *e : used_)
+				ids.push_back(e->id);
+			hints_.clear();
+			for (int v : top_vars)
+				hints_.push_back(unit_id(v));
+			hints_.insert(hints_.end(), ids.begin(), ids.end());
+			ok = check(lemma);
+		}
+	}
+	if (!ok && !conflict_)
+		ok = (rup(lemma) && check(lemma)) || rat(lemma);
+	if (!ok)
+		throw std::runtime_error(
+		    fmt::format("proof step '{}' is neither RUP nor RAT",
+		                fmt::join(lemma, " ")));
+
+	uint64_t id = next_id_++;
+	write_add(id, lemma, hints_);
+	if (lemma.empty())
+		done_ = true;
+	else
+		insert(id, lemma);
+}
+
+void LratBuilder::del(std::string &out, std::span<const Lit> cl)
+{
+	if (done_ || cl.size() <= 1)
+		return;
+	out_ = &out;
+
+	Entry *e = find(cl);
+	if (!e || e == conflict_)
+		return;
+	for (Lit a : e->lits)
+		if (value_[a] && reason_[a.var()] == e)
+			return;
+
+	uint64_t id = e->id;
+	remove(*e);
+	write_delete(id);
+}
+
+void LratBuilder::write_add(uint64_t id, std::span<const Lit> lits,
+                            std::span<const int64_t> hints)
+{
+	auto &out = *out_;
+	if (binary_)
+	{
+		out.push_back('a');
+		put_varint(out, 2 * id);
+		for (Lit a : lits)
+			put_varint(out, (uint32_t)a + 2);
+		out.push_back(0);
+		for (int64_t h : hints)
+			put_varint(out, h < 0 ? 2 * (uint64_t)-h + 1 : 2 * (uint64_t)h);
+		out.push_back(0);
+	}
+	else
+	{
+		auto it = fmt::format_to(std::back_inserter(out), "{} ", id);
+		for (Lit a : lits)
+			it = fmt::format_to(it, "{} ", a);
+		out += "0 ";
+		for (int64_t h : hints)
+			it = fmt::format_to(it, "{} ", h);
+		out += "0\n";
+	}
+}
+
+void LratBuilder::write_delete(uint64_t id)
+{
+	auto &out = *out_;
+	if (binary_)
+	{
+		out.push_back('d');
+		put_varint(out, 2 * id);
+		out.push_back(0);
+	}
+	else
+		fmt::format_to(std::back_inserter(out), "{} d {} 0\n", next_id_ - 1,
+		               id);
+}
+
+} // namespace dawn
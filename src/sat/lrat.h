@@ -0,0 +1,89 @@
+#pragma once
+
+#include "sat/clause.h"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dawn {
+
+// Turns a stream of DRAT-like proof steps into an LRAT proof, i.e., assigns
+// an ID to every clause and adds hints to every lemma.
+//   * clauses are identified by content, so the solver does not have to keep
+//     track of IDs (which would be awkward for the implicit binary clauses)
+//   * hints are taken from the antecedents of a lemma if the solver provides
+//     them. Otherwise (or if they turn out to be insufficient) they are found
+//     by unit propagation (RUP) or by resolution candidates (RAT).
+//   * top-level units are explicitly derived (as hinted lemmas) when needed
+//   * deleting a clause which is the reason of a top-level unit is ignored,
+//     deleting a clause that does not exist as well (units in particular)
+class LratBuilder
+{
+	struct Entry
+	{
+		uint64_t id;
+		std::vector<Lit> lits; // sorted on creation, watched on [0] and [1]
+		bool attached = false;
+	};
+
+	std::unordered_map<uint64_t, Entry> clauses_;        // id -> clause
+	std::unordered_multimap<uint64_t, uint64_t> index_; // content hash -> id
+	std::vector<std::vector<Entry *>> watches_;
+	uint64_t next_id_;
+	bool binary_;
+	std::string *out_ = nullptr;
+
+	// top-level assignment, plus temporary assignments beyond 'top_'
+	std::vector<uint8_t> value_; // indexed by literal
+	std::vector<Entry *> reason_;
+	std::vector<size_t> trail_pos_;
+	std::vector<uint64_t> unit_; // ID of the unit clause of a top-level var
+	std::vector<Lit> trail_;
+	size_t top_ = 0, qhead_ = 0;
+	Entry *conflict_ = nullptr; // top-level conflict
+	bool done_ = false;         // empty clause written
+
+	// temporaries
+	std::vector<uint8_t> seen_, in_lemma_, check_;
+	std::vector<int> touched_;
+	std::vector<Lit> tmp_, checked_;
+	std::vector<int64_t> hints_;
+	std::vector<Entry *> used_;
+
+	void ensure_var(Lit a);
+	bool assigned(int v) const;
+	void assign(Lit a, Entry *reason);
+	Entry *propagate();
+	void backtrack();
+
+	Entry *find(std::span<const Lit> lits);
+	Entry &insert(uint64_t id, std::span<const Lit> lits);
+	void attach(Entry &e);
+	void remove(Entry &e);
+
+	uint64_t unit_id(int v);
+	void explain(Entry *confl, std::span<const Lit> assumptions);
+	bool check(std::span<const Lit> lemma);
+	bool rup(std::span<const Lit> lemma);
+	bool rat(std::span<const Lit> lemma);
+
+	void write_add(uint64_t id, std::span<const Lit> lits,
+	               std::span<const int64_t> hints);
+	void write_delete(uint64_t id);
+
+  public:
+	// original clauses are numbered 1, 2, ... in order
+	LratBuilder(ClauseStorage const &original, bool binary);
+
+	// add a lemma. 'chain' optionally lists antecedent clauses (each followed
+	// by Lit::undef()) in order of propagation, the last one being falsified.
+	void add(std::string &out, std::span<const Lit> lemma,
+	         std::span<const Lit> chain = {});
+
+	// delete a clause
+	void del(std::string &out, std::span<const Lit> cl);
+};
+
+} // namespace dawn
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "sat/activity_heap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace dawn {
+
+/**
+ * Learning-rate based branching (LRB, Liang et al. 2016). The score of a
+ * variable is an exponential recency weighted average (ERWA) of its 'learning
+ * rate', i.e., the fraction of conflicts it participated in while it was
+ * assigned.
+ *   * same queue interface as ActivityHeap/VmtfQueue. Additionally, the
+ *     PropEngine calls 'unassign' with the number of conflicts the variable
+ *     was assigned for (see PropEngine::unroll), which updates the score.
+ *   * the step size of the ERWA starts at 0.4 and decreases to 0.06
+ *   * 'locality' extension: scores of unassigned variables decay by 0.95 per
+ *     conflict. This is done lazily when they reach the top of the heap.
+ *   * 'reason side rate' extension: variables that imply the learnt clause
+ *     count as participating as well
+ */
+class LrbQueue
+{
+	ActivityHeap heap_;
+	std::vector<int32_t> participated_; // conflicts since assignment
+	std::vector<int32_t> reasoned_;     // reason side since assignment
+	std::vector<int64_t> decayed_;      // conflict count of last decay
+	int64_t conflicts_ = 0;
+	double alpha_ = 0.4;
+
+  public:
+	explicit LrbQueue(int var_count)
+	    : heap_(var_count), participated_(var_count), reasoned_(var_count),
+	      decayed_(var_count)
+	{
+		heap_.set_decay(1.0);
+	}
+
+	bool empty() const { return heap_.empty(); }
+
+	int pop()
+	{
+		while (true)
+		{
+			int var = heap_.pop();
+			int64_t age = conflicts_ - decayed_[var];
+			if (age == 0)
+				return var;
+			decayed_[var] = conflicts_;
+			heap_.set_activity(var, heap_.activity(var) *
+			                            (float)std::pow(0.95, (double)age));
+			heap_.push(var);
+		}
+	}
+
+	void push(int var) { heap_.push(var); }
+
+	// variable was unassigned after being assigned for 'interval' conflicts
+	void unassign(int var, int64_t interval)
+	{
+		if (interval > 0)
+		{
+			double rate =
+			    (double)(participated_[var] + reasoned_[var]) / interval;
+			double score = (1 - alpha_) * heap_.activity(var) + alpha_ * rate;
+			heap_.set_activity(var, (float)score);
+		}
+		participated_[var] = 0;
+		reasoned_[var] = 0;
+		decayed_[var] = conflicts_;
+		heap_.push(var);
+	}
+
+	// variable participated in the current conflict (called during analysis)
+	void bump_variable_activity(int var) { participated_[var] += 1; }
+
+	// variable is in a reason of the learnt clause (but did not participate)
+	void bump_reason_side(int var) { reasoned_[var] += 1; }
+
+	// end of conflict analysis
+	void decay_variable_activity()
+	{
+		conflicts_ += 1;
+		alpha_ = std::max(0.06, alpha_ - 1e-6);
+	}
+};
+
+} // namespace dawn
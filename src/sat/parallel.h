@@ -0,0 +1,68 @@
+#pragma once
+
+// minimal helpers for running (pre/in-)processing passes on multiple threads
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dawn {
+
+// Number of worker threads to actually use.
+//   * 'threads <= 0' means "all available cores"
+//   * never more than 'max_useful', which should be the number of independent
+//     work items, so that tiny problems do not pay for spawning threads
+inline int effective_threads(int threads, size_t max_useful = SIZE_MAX)
+{
+	if (threads <= 0)
+		threads = (int)std::max(1u, std::thread::hardware_concurrency());
+	if ((size_t)threads > max_useful)
+		threads = (int)std::max(max_useful, size_t(1));
+	return threads;
+}
+
+// Run 'f(t)' for t = 0,...,n-1 concurrently and wait for all of them.
+//   * 'f(0)' is executed on the calling thread
+//   * the first exception thrown by any worker is re-thrown after all workers
+//     are finished
+template <class F> void run_parallel(int n, F &&f)
+{
+	assert(n >= 1);
+	std::vector<std::exception_ptr> errors(n);
+	auto work = [&](int t) {
+		try
+		{
+			f(t);
+		}
+		catch (...)
+		{
+			errors[t] = std::current_exception();
+		}
+	};
+
+	{
+		std::vector<std::jthread> workers;
+		workers.reserve(n - 1);
+		for (int t = 1; t < n; ++t)
+			workers.emplace_back(work, t);
+		work(0);
+	} // destructors of std::jthread join all workers
+
+	for (auto &e : errors)
+		if (e)
+			std::rethrow_exception(e);
+}
+
+// Split the index range [0, n) into 'parts' contiguous pieces of (almost)
+// equal size and return the boundaries of piece 'i'.
+inline std::pair<size_t, size_t> split_range(size_t n, int parts, int i)
+{
+	assert(parts >= 1 && 0 <= i && i < parts);
+	return {n * i / parts, n * (i + 1) / parts};
+}
+
+} // namespace dawn
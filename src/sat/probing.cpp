@@ -1,56 +1,32 @@
 #include "sat/probing.h"
 
+#include "sat/parallel.h"
 #include "sat/propengine.h"
+#include <algorithm>
 #include <climits>
 
 using namespace dawn;
 
-int dawn::probe_binary(Cnf &cnf)
+namespace {
+
+// learnt clauses of (a shard of) binary probing
+struct BinProbeResult
 {
-	// basic structure:
-	//   for (Lit a)
-	//       for (Lit b)
-	//           if (probe(a, b) == conflict)
-	//               learn (-a,-b)
-	// some optimizations:
-	//   * If no conflict arises when propagating b and b implies b', then no
-	//     conflict can arise when propagating b' instead of b. This is
-	//     implemented using the 'seenB' array.
-	//   * If a implies a', everything that is not-conflicting with a is also
-	//     not-conflicting with a'. This is implemented by opportunistically
-	//     re-using the 'seenB' array.
-	//   * To maximize the effect of the above, both loops should be in
-	//     topological order.
-	//   * TODO: Dont 'just' learn (-a,-b) on conflict, but do actual conflict
-	//     analysis. Currently, we are paying for the the full capability of
-	//     'PropEngine' without using it.
-	//   * TODO: be more careful which combinations of 'a' and 'b' need probing,
-	//     depending on their position in the binary implication graph:
-	//     - both 'a' and 'b' are sinks or isolated points: Can only conflict if
-	//       they appear together in a ternary clause. This is handled in
-	//       vivification already, so we can skip it here.
-	//     - 'a' and 'b' belong to different weakly connected components: Only
-	//       probe if both are sources.
-	//   * TODO: randomize probing order a bit and implement a cutoff in order
-	//     to do a partial run on large CNFs.
+	// learnt units (second=undef) and binaries in order of derivation. The
+	// order matters for proof logging.
+	std::vector<std::pair<Lit, Lit>> learnts;
+	bool contradiction = false;
+	int64_t nTries = 0;
+};
 
-	auto log = util::Logger("bin-probing");
+// do binary probing for all 'a' with 'owned(a)' (see 'probe_binary' below)
+template <class F>
+void probe_binary_shard(Cnf const &cnf, TopOrder const &top, F owned,
+                        BinProbeResult &r)
+{
 	auto p = PropEngine(cnf);
-	auto top = TopOrder(cnf.bins);
-
-	// sanity check. Not strictly necessary, but running (expensive) bin-probing
-	// without (cheap) normalization first is a waste of time.
-	if (!top.valid || p.conflict || !cnf.units.empty())
-	{
-		log.warning("CNF not normalized, skipping bin-probing.");
-		return 0;
-	}
-
 	auto seenA = util::bit_vector(cnf.var_count() * 2);
 	auto seenB = util::bit_vector(cnf.var_count() * 2);
-	int nTries = 0;
-	int nUnitFails = 0;
-	int nBinFails = 0;
 
 	for (Lit a : top.lits)
 	{
@@ -58,12 +34,12 @@ int dawn::probe_binary(Cnf &cnf)
 		assert(p.level() == 0);
 		if (p.conflict) [[unlikely]]
 		{
-			cnf.add_empty();
+			r.contradiction = true;
 			break;
 		}
 
 		seenB.clear();
-		if (p.assign[a] || p.assign[a.neg()] || seenA[a])
+		if (!owned(a) || p.assign[a] || p.assign[a.neg()] || seenA[a])
 			continue;
 
 	use_this_a:
@@ -76,9 +52,8 @@ int dawn::probe_binary(Cnf &cnf)
 			// failed literal -> learn unit
 			if (p.conflict)
 			{
-				nUnitFails += 1;
 				p.unroll();
-				cnf.add_unary(a.neg());
+				r.learnts.push_back({a.neg(), Lit::undef()});
 				p.propagate(a.neg());
 				goto next_a;
 			}
@@ -91,13 +66,12 @@ int dawn::probe_binary(Cnf &cnf)
 
 			p.branch(b);
 			assert(p.level() == 2);
-			nTries += 1;
+			r.nTries += 1;
 
 			if (p.conflict)
 			{
-				nBinFails += 1;
 				p.unroll();
-				cnf.add_binary(a.neg(), b.neg());
+				r.learnts.push_back({a.neg(), b.neg()});
 				p.add_clause({a.neg(), b.neg()}, Color::green);
 				p.propagate(b.neg());
 				continue;
@@ -115,7 +89,7 @@ int dawn::probe_binary(Cnf &cnf)
 		// Done with this 'a'. Try to get a weaker 'a' next in order to reuse
 		// the 'seenB' array
 		for (Lit a2 : p.bins[a.neg()])
-			if (!(p.assign[a2] || p.assign[a2.neg()] || seenA[a2]))
+			if (owned(a2) && !(p.assign[a2] || p.assign[a2.neg()] || seenA[a2]))
 			{
 				a = a2;
 				goto use_this_a;
@@ -123,6 +97,86 @@ int dawn::probe_binary(Cnf &cnf)
 
 	next_a:;
 	}
+}
+
+} // namespace
+
+int dawn::probe_binary(Cnf &cnf, int threads)
+{
+	// basic structure:
+	//   for (Lit a)
+	//       for (Lit b)
+	//           if (probe(a, b) == conflict)
+	//               learn (-a,-b)
+	// some optimizations:
+	//   * If no conflict arises when propagating b and b implies b', then no
+	//     conflict can arise when propagating b' instead of b. This is
+	//     implemented using the 'seenB' array.
+	//   * If a implies a', everything that is not-conflicting with a is also
+	//     not-conflicting with a'. This is implemented by opportunistically
+	//     re-using the 'seenB' array.
+	//   * To maximize the effect of the above, both loops should be in
+	//     topological order.
+	//   * The outer loop is trivially parallel. Each thread owns a contiguous
+	//     range of the topological order (so that the re-use of 'seenB' is
+	//     mostly preserved) and its own PropEngine. Units learnt by one
+	//     thread are not visible to the others until the merge at the end.
+	//   * TODO: Dont 'just' learn (-a,-b) on conflict, but do actual conflict
+	//     analysis. Currently, we are paying for the the full capability of
+	//     'PropEngine' without using it.
+	//   * TODO: be more careful which combinations of 'a' and 'b' need probing,
+	//     depending on their position in the binary implication graph:
+	//     - both 'a' and 'b' are sinks or isolated points: Can only conflict if
+	//       they appear together in a ternary clause. This is handled in
+	//       vivification already, so we can skip it here.
+	//     - 'a' and 'b' belong to different weakly connected components: Only
+	//       probe if both are sources.
+	//   * TODO: randomize probing order a bit and implement a cutoff in order
+	//     to do a partial run on large CNFs.
+
+	auto log = util::Logger("bin-probing");
+	auto top = TopOrder(cnf.bins);
+
+	// sanity check. Not strictly necessary, but running (expensive) bin-probing
+	// without (cheap) normalization first is a waste of time.
+	if (!top.valid || cnf.contradiction || !cnf.units.empty())
+	{
+		log.warning("CNF not normalized, skipping bin-probing.");
+		return 0;
+	}
+
+	threads = effective_threads(threads, top.lits.size());
+	auto results = std::vector<BinProbeResult>(threads);
+	run_parallel(threads, [&](int t) {
+		auto [lo, hi] = split_range(top.lits.size(), threads, t);
+		auto owned = [&](Lit a) {
+			return lo <= (size_t)top.order[a] && (size_t)top.order[a] < hi;
+		};
+		probe_binary_shard(cnf, top, owned, results[t]);
+	});
+
+	int64_t nTries = 0;
+	int nUnitFails = 0;
+	int nBinFails = 0;
+	for (auto &r : results)
+	{
+		for (auto [a, b] : r.learnts)
+		{
+			if (b == Lit::undef())
+			{
+				cnf.add_unary(a);
+				nUnitFails += 1;
+			}
+			else
+			{
+				cnf.add_binary(a, b);
+				nBinFails += 1;
+			}
+		}
+		if (r.contradiction)
+			cnf.add_empty();
+		nTries += r.nTries;
+	}
 
 	log.info("found {} units and {} bins using {:.2f}M tries", nUnitFails,
 	         nBinFails, nTries / 1e6);
@@ -161,10 +215,83 @@ Lit probe(Lit a, PropEngineLight &p, util::bit_vector &done)
 }
 } // namespace
 
-bool dawn::run_probing(Cnf &cnf)
+namespace {
+
+// in-tree probing of the sinks 'roots' on a private copy of the formula.
+// Returns learnt units, new hyper-binaries are appended to 'hbr'.
+std::vector<Lit> probe_shard(Cnf const &cnf, std::span<const Lit> roots,
+                             std::vector<std::pair<Lit, Lit>> &hbr)
+{
+	auto local = Cnf(cnf.var_count());
+	local.bins = cnf.bins;
+	local.clauses = cnf.clauses;
+
+	std::vector<Lit> units;
+	auto p = PropEngineLight(local);
+	if (p.conflict)
+		return units;
+	auto done = util::bit_vector(local.var_count() * 2);
+	for (Lit a : roots)
+		if (Lit u = probe(a, p, done); u != Lit::undef())
+		{
+			units.push_back(u);
+			p.propagate(u);
+			if (p.conflict)
+				break;
+		}
+
+	// binaries are only ever appended during propagation, so everything
+	// beyond the original list is a new hyper-binary
+	for (Lit a : local.all_lits())
+		for (size_t i = cnf.bins[a].size(); i < local.bins[a].size(); ++i)
+			if (Lit b = local.bins[a][i]; a < b)
+				hbr.push_back({a, b});
+	return units;
+}
+
+} // namespace
+
+bool dawn::run_probing(Cnf &cnf, int threads)
 {
 	if (cnf.contradiction)
 		return false;
+
+	// copying the formula for each thread only pays off on large formulas
+	threads = effective_threads(threads, cnf.var_count() / 10'000);
+	if (threads > 1 && cnf.units.empty())
+	{
+		std::vector<Lit> roots;
+		for (Lit a : cnf.all_lits())
+			if (!cnf.bins[a].empty() && cnf.bins[a.neg()].empty())
+				roots.push_back(a);
+
+		auto units = std::vector<std::vector<Lit>>(threads);
+		auto hbr = std::vector<std::vector<std::pair<Lit, Lit>>>(threads);
+		run_parallel(threads, [&](int t) {
+			auto [lo, hi] = split_range(roots.size(), threads, t);
+			units[t] = probe_shard(
+			    cnf, std::span(roots).subspan(lo, hi - lo), hbr[t]);
+		});
+
+		// different threads might find the same hyper-binaries
+		std::vector<std::pair<Lit, Lit>> bins;
+		for (auto &h : hbr)
+			bins.insert(bins.end(), h.begin(), h.end());
+		std::sort(bins.begin(), bins.end());
+		bins.erase(std::unique(bins.begin(), bins.end()), bins.end());
+		for (auto [a, b] : bins)
+			cnf.add_binary(a, b);
+
+		int64_t nUnits = 0;
+		for (auto &us : units)
+			for (Lit u : us)
+			{
+				cnf.add_unary(u);
+				nUnits += 1;
+			}
+		return nUnits || !bins.empty();
+	}
+
 	auto p = PropEngineLight(cnf);
 	if (p.conflict)
 		return true;
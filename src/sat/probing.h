@@ -9,10 +9,15 @@ namespace dawn {
 //   * should be faster than the traditional "probing all roots"
 //   * includes full hyper-binary resolution
 //   * returns true if any progress was made
-bool run_probing(Cnf &cnf);
+//   * with multiple threads, the roots are split into shards, each probed on
+//     a private copy of the formula. Learnt units and hyper-binaries are
+//     merged afterwards.
+bool run_probing(Cnf &cnf, int threads = 1);
 
 // Probe for binaries.
 // Quite expensive and probably not woth it for most problems.
-int probe_binary(Cnf &cnf);
+//   * with multiple threads, the outer loop of the (quadratic) search is split
+//     into shards along the topological order
+int probe_binary(Cnf &cnf, int threads = 1);
 
 } // namespace dawn
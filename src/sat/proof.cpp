@@ -0,0 +1,219 @@
+#include "sat/proof.h"
+
+#include "fmt/format.h"
+#include "sat/proof_format.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace dawn {
+
+ProofWriter::ProofWriter(std::string const &filename, bool binary)
+    : ProofWriter(filename, binary, nullptr)
+{}
+
+ProofWriter::ProofWriter(std::string const &filename,
+                         ClauseStorage const &original, bool binary)
+    : ProofWriter(filename, binary, &original)
+{}
+
+ProofWriter::ProofWriter(std::string const &filename, bool binary,
+                         ClauseStorage const *original)
+    : file_(std::fopen(filename.c_str(), "wb")), binary_(binary),
+      lrat_(original ? std::optional<LratBuilder>(std::in_place, *original,
+                                                   binary)
+                     : std::nullopt),
+      worker_([this] { run(); })
+{
+	if (!file_)
+	{
+		{
+			auto lock = std::unique_lock(mutex_);
+			stopping_ = true;
+		}
+		cv_.notify_all();
+		worker_.join();
+		throw std::runtime_error(
+		    fmt::format("could not open '{}': {}", filename, strerror(errno)));
+	}
+	buf_.reserve(buffer_size + 1024);
+}
+
+ProofWriter::~ProofWriter()
+{
+	{
+		auto lock = std::unique_lock(mutex_);
+		if (!buf_.empty() && !error_)
+			queue_.push_back(std::move(buf_));
+		stopping_ = true;
+	}
+	cv_.notify_all();
+	worker_.join(); // writes everything still queued
+	std::fclose(file_);
+}
+
+void ProofWriter::run()
+{
+	while (true)
+	{
+		std::string block;
+		{
+			auto lock = std::unique_lock(mutex_);
+			cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+			if (queue_.empty())
+				return;
+			block = std::move(queue_.front());
+			queue_.pop_front();
+			busy_ = true;
+		}
+
+		std::exception_ptr error;
+		try
+		{
+			if (lrat_)
+			{
+				std::string out;
+				translate(block, out);
+				block = std::move(out);
+			}
+			if (std::fwrite(block.data(), 1, block.size(), file_) !=
+			    block.size())
+				throw std::runtime_error(fmt::format(
+				    "error while writing proof: {}", strerror(errno)));
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		auto lock = std::unique_lock(mutex_);
+		busy_ = false;
+		if (error)
+		{
+			error_ = error;
+			queue_.clear();
+			cv_.notify_all();
+			return;
+		}
+		cv_.notify_all();
+	}
+}
+
+void ProofWriter::translate(std::string const &block, std::string &out)
+{
+	// records as written by 'write' (binary, plus antecedents for LRAT)
+	size_t pos = 0;
+	auto next = [&]() -> Lit {
+		uint32_t x = 0;
+		for (int shift = 0;; shift += 7)
+		{
+			auto b = (uint8_t)block[pos++];
+			x |= (uint32_t)(b & 127) << shift;
+			if (!(b & 128))
+				break;
+		}
+		return x == 0 ? Lit::undef() : Lit(x - 2);
+	};
+
+	std::vector<Lit> cl, chain;
+	while (pos < block.size())
+	{
+		char kind = block[pos++];
+		cl.clear();
+		for (Lit a = next(); a != Lit::undef(); a = next())
+			cl.push_back(a);
+		if (kind == 'd')
+		{
+			lrat_->del(out, cl);
+			continue;
+		}
+
+		chain.clear();
+		if (kind == 'h')
+			while (true)
+			{
+				size_t start = chain.size();
+				for (Lit a = next(); a != Lit::undef(); a = next())
+					chain.push_back(a);
+				if (chain.size() == start)
+					break;
+				chain.push_back(Lit::undef());
+			}
+		lrat_->add(out, cl, chain);
+	}
+}
+
+void ProofWriter::write(char kind, std::span<const Lit> cl,
+                        std::span<const Lit> chain)
+{
+	if (binary_ || lrat_)
+	{
+		// binary DRAT: literal 'x' is encoded as 2*|x|+sign(x) in a
+		// variable-length format (7 bits per byte, least significant first).
+		// For LRAT, antecedents follow as a list of clauses in the same
+		// format, terminated by an empty one.
+		auto put = [&](Lit a) {
+			assert(a.proper());
+			put_varint(buf_, (uint32_t)a + 2);
+		};
+		bool with_chain = lrat_ && !chain.empty();
+		buf_.push_back(with_chain ? 'h' : kind);
+		for (Lit a : cl)
+			put(a);
+		buf_.push_back(0);
+		if (with_chain)
+		{
+			for (Lit a : chain)
+				if (a == Lit::undef())
+					buf_.push_back(0);
+				else
+					put(a);
+			buf_.push_back(0);
+		}
+	}
+	else
+	{
+		auto it = std::back_inserter(buf_);
+		if (kind == 'd')
+			buf_ += "d ";
+		for (Lit a : cl)
+			it = fmt::format_to(it, "{} ", a);
+		buf_ += "0\n";
+	}
+
+	if (buf_.size() >= buffer_size) [[unlikely]]
+		submit(false);
+}
+
+void ProofWriter::submit(bool wait)
+{
+	auto lock = std::unique_lock(mutex_);
+	cv_.wait(lock, [&] { return error_ || queue_.size() < max_buffers; });
+	if (error_)
+		std::rethrow_exception(error_);
+	if (!buf_.empty())
+	{
+		queue_.push_back(std::move(buf_));
+		buf_ = std::string();
+		buf_.reserve(buffer_size + 1024);
+		cv_.notify_all();
+	}
+	if (wait)
+	{
+		cv_.wait(lock, [&] { return error_ || (queue_.empty() && !busy_); });
+		if (error_)
+			std::rethrow_exception(error_);
+	}
+}
+
+void ProofWriter::flush()
+{
+	submit(true);
+
+	// background thread is idle at this point
+	if (std::fflush(file_) != 0)
+		throw std::runtime_error(
+		    fmt::format("error while writing proof: {}", strerror(errno)));
+}
+
+} // namespace dawn
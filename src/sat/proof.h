@@ -0,0 +1,91 @@
+#pragma once
+
+#include "sat/clause.h"
+#include "sat/lrat.h"
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+
+namespace dawn {
+
+// Writes a DRAT or LRAT proof (for checking UNSAT results with e.g.
+// drat-trim or cake_lpr).
+//   * clauses are given in terms of the original (outer) variables, i.e.
+//     translating from the current inner numbering is the callers job
+//   * output is collected in large buffers, which are written to disk by a
+//     background thread. Thus the solver only blocks if the disk is slower
+//     than proof generation.
+//   * for LRAT, the background thread also assigns clause IDs and hints (see
+//     LratBuilder). Lemmas can come with their antecedents to make this cheap.
+//   * binary format by default, text format is useful for debugging
+//   * errors on the background thread are re-thrown by the next call
+class ProofWriter
+{
+	std::FILE *file_;
+	bool binary_;
+	std::string buf_; // currently filled by the solver
+	std::optional<LratBuilder> lrat_;
+
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::deque<std::string> queue_; // waiting to be written
+	bool busy_ = false;             // background thread is writing
+	bool stopping_ = false;
+	std::exception_ptr error_;
+
+	std::jthread worker_; // declared last, so that it is joined first
+
+	ProofWriter(std::string const &filename, bool binary,
+	            ClauseStorage const *original);
+	void run();
+	void translate(std::string const &block, std::string &out);
+	void write(char kind, std::span<const Lit> cl,
+	           std::span<const Lit> chain = {});
+	void submit(bool wait);
+
+  public:
+	static constexpr size_t buffer_size = 4 << 20;
+	static constexpr size_t max_buffers = 4;
+
+	// DRAT proof
+	explicit ProofWriter(std::string const &filename, bool binary = true);
+
+	// LRAT proof, which refers to the original clauses (in order of the input
+	// file) by their index
+	ProofWriter(std::string const &filename, ClauseStorage const &original,
+	            bool binary = true);
+
+	~ProofWriter();
+
+	ProofWriter(ProofWriter const &) = delete;
+	ProofWriter &operator=(ProofWriter const &) = delete;
+
+	// true if antecedents given to 'add' are used (otherwise no need to
+	// compute them)
+	bool wants_chain() const { return lrat_.has_value(); }
+
+	// add a clause which is redundant w.r.t. all clauses added so far
+	void add(std::span<const Lit> cl) { write('a', cl); }
+
+	// add a clause which follows by unit propagation of 'chain', which lists
+	// clauses (each followed by Lit::undef()) in order of propagation, the
+	// last one being in conflict
+	void add(std::span<const Lit> cl, std::span<const Lit> chain)
+	{
+		write('a', cl, chain);
+	}
+
+	// remove a clause (deletion of units is ignored by most checkers)
+	void del(std::span<const Lit> cl) { write('d', cl); }
+
+	// write everything buffered so far to disk and wait for it to finish
+	void flush();
+};
+
+} // namespace dawn
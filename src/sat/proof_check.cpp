@@ -0,0 +1,933 @@
+#include "sat/proof_check.h"
+
+#include "fmt/format.h"
+#include "sat/decompress.h"
+#include "sat/proof_format.h"
+#include "util/logging.h"
+#include "util/stopwatch.h"
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace dawn {
+
+namespace {
+
+// Sequential reader for a (possibly compressed) file. Unlike 'BlockStream',
+// blocks are not aligned to line breaks, as binary proofs have none.
+class ByteReader
+{
+	std::FILE *file_ = nullptr;
+	std::unique_ptr<Decompressor> decompressor_;
+	std::string buf_;
+	size_t pos_ = 0, end_ = 0;
+
+	bool refill()
+	{
+		pos_ = 0;
+		if (decompressor_)
+			end_ = decompressor_->read(buf_.data(), buf_.size());
+		else
+		{
+			end_ = std::fread(buf_.data(), 1, buf_.size(), file_);
+			if (end_ == 0 && std::ferror(file_))
+				throw std::runtime_error(fmt::format(
+				    "error while reading proof: {}", strerror(errno)));
+		}
+		return end_ != 0;
+	}
+
+  public:
+	explicit ByteReader(std::string const &filename) : buf_(1 << 20, '\0')
+	{
+		if (auto compression = detect_compression(filename);
+		    compression != Compression::none)
+			decompressor_ = open_decompressor(filename, compression);
+		else if (file_ = std::fopen(filename.c_str(), "rb"); !file_)
+			throw std::runtime_error(fmt::format("could not open '{}': {}",
+			                                     filename, strerror(errno)));
+	}
+
+	~ByteReader()
+	{
+		if (file_)
+			std::fclose(file_);
+	}
+
+	ByteReader(ByteReader const &) = delete;
+	ByteReader &operator=(ByteReader const &) = delete;
+
+	int peek()
+	{
+		if (pos_ == end_ && !refill())
+			return EOF;
+		return (unsigned char)buf_[pos_];
+	}
+
+	int get()
+	{
+		int c = peek();
+		if (c != EOF)
+			++pos_;
+		return c;
+	}
+
+	// currently buffered content (for format detection)
+	std::string_view buffered()
+	{
+		peek();
+		return std::string_view(buf_.data() + pos_, end_ - pos_);
+	}
+};
+
+struct ProofStep
+{
+	bool del = false;
+	int64_t id = 0;             // LRAT only
+	std::vector<Lit> lits;      // empty for LRAT deletions
+	std::vector<int64_t> hints; // LRAT only. deleted IDs for deletions
+};
+
+// Parses DRAT or LRAT proofs, in text or binary format (auto-detected)
+class ProofParser
+{
+	ByteReader in_;
+	bool lrat_;
+	bool binary_ = false;
+	int64_t count_ = 0;
+
+	[[noreturn]] void error(std::string_view msg)
+	{
+		throw std::runtime_error(
+		    fmt::format("invalid proof (step {}): {}", count_, msg));
+	}
+
+	// skip whitespace and comments, returns next char (without consuming it)
+	int skip_space()
+	{
+		while (true)
+		{
+			int c = in_.peek();
+			if (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+				in_.get();
+			else if (c == 'c')
+				while (c != EOF && c != '\n')
+					c = in_.get();
+			else
+				return c;
+		}
+	}
+
+	int64_t read_int()
+	{
+		int c = skip_space();
+		bool neg = c == '-';
+		if (neg)
+		{
+			in_.get();
+			c = in_.peek();
+		}
+		if (c < '0' || c > '9')
+			error("expected a number");
+		int64_t x = 0;
+		for (; c >= '0' && c <= '9'; c = in_.peek())
+		{
+			if (x > (INT64_MAX - 9) / 10)
+				error("number too large");
+			x = 10 * x + (c - '0');
+			in_.get();
+		}
+		return neg ? -x : x;
+	}
+
+	// 7 bits per byte, least significant first
+	uint64_t read_varint()
+	{
+		uint64_t x = 0;
+		for (int shift = 0;; shift += 7)
+		{
+			int c = in_.get();
+			if (c == EOF)
+				error("unexpected end of file");
+			if (shift > 56)
+				error("number too large");
+			x |= uint64_t(c & 127) << shift;
+			if (!(c & 128))
+				return x;
+		}
+	}
+
+	Lit text_lit(int64_t x)
+	{
+		if (x < -(INT_MAX / 2) || x > INT_MAX / 2)
+			error("variable number too large");
+		return Lit::fromDimacs((int)x);
+	}
+
+	Lit binary_lit(uint64_t x)
+	{
+		if (x > (uint64_t)INT_MAX)
+			error("variable number too large");
+		return Lit((uint32_t)(x - 2));
+	}
+
+  public:
+	ProofParser(std::string const &filename, bool lrat)
+	    : in_(filename), lrat_(lrat)
+	{
+		// text proofs start with a number, a comment or "d "
+		auto head = in_.buffered();
+		binary_ = !head.empty() &&
+		          (head[0] == 'a' ||
+		           (head[0] == 'd' && (head.size() < 2 || head[1] != ' ')));
+	}
+
+	bool binary() const { return binary_; }
+
+	// read the next step, returns false at the end of the proof
+	bool next(ProofStep &step)
+	{
+		step.del = false;
+		step.id = 0;
+		step.lits.clear();
+		step.hints.clear();
+
+		if (binary_)
+		{
+			int c = in_.get();
+			if (c == EOF)
+				return false;
+			++count_;
+			if (c != 'a' && c != 'd')
+				error("expected 'a' or 'd'");
+			step.del = c == 'd';
+			if (!lrat_ || !step.del)
+			{
+				if (lrat_)
+					step.id = (int64_t)(read_varint() / 2);
+				for (uint64_t x; (x = read_varint()) != 0;)
+					step.lits.push_back(binary_lit(x));
+			}
+			if (lrat_)
+				for (uint64_t x; (x = read_varint()) != 0;)
+					step.hints.push_back((x & 1) ? -(int64_t)(x >> 1)
+					                             : (int64_t)(x >> 1));
+			return true;
+		}
+
+		if (skip_space() == EOF)
+			return false;
+		++count_;
+		if (lrat_)
+			step.id = read_int();
+		if (skip_space() == 'd')
+		{
+			in_.get();
+			step.del = true;
+		}
+		if (!lrat_ || !step.del)
+			for (int64_t x; (x = read_int()) != 0;)
+				step.lits.push_back(text_lit(x));
+		if (lrat_)
+			for (int64_t x; (x = read_int()) != 0;)
+				step.hints.push_back(x);
+		return true;
+	}
+};
+
+// sort and remove duplicates. returns false for tautologies
+bool normalize_sorted(std::vector<Lit> &lits)
+{
+	std::sort(lits.begin(), lits.end());
+	lits.erase(std::unique(lits.begin(), lits.end()), lits.end());
+	for (size_t i = 1; i < lits.size(); ++i)
+		if (lits[i] == lits[i - 1].neg())
+			return false;
+	if (lits.size() > Clause::max_size())
+		throw std::runtime_error(
+		    fmt::format("clause of size {} in proof is too long (max {})",
+		                lits.size(), Clause::max_size()));
+	return true;
+}
+
+class DratChecker
+{
+	ClauseStorage clauses_;
+	std::vector<std::vector<CRef>> watches_;
+	std::unordered_multimap<uint64_t, CRef> index_; // for deletions
+
+	struct Step
+	{
+		CRef cref;
+		bool del;
+		Lit pivot; // first literal as written in the proof (for RAT)
+	};
+	std::vector<Step> steps_;
+
+	// top-level assignment, plus temporary assignments beyond 'top_'
+	std::vector<uint8_t> value_; // indexed by literal
+	std::vector<CRef> reason_;
+	std::vector<size_t> trail_pos_;
+	std::vector<uint8_t> core_unit_; // derivation of top-level unit is core
+	std::vector<Lit> trail_;
+	size_t top_ = 0;
+	size_t head_core_ = 0, head_all_ = 0; // propagation queues
+	CRef conflict_ = CRef::undef();       // top-level conflict
+
+	// temporaries
+	std::vector<uint8_t> seen_;
+	std::vector<Lit> resolvent_;
+	std::vector<CRef> stack_;
+
+	void ensure_var(Lit a)
+	{
+		assert(a.proper());
+		if ((size_t)a.var() < reason_.size())
+			return;
+		size_t n = a.var() + 1;
+		value_.resize(2 * n);
+		watches_.resize(2 * n);
+		reason_.resize(n, CRef::undef());
+		trail_pos_.resize(n);
+		core_unit_.resize(n);
+		seen_.resize(n);
+	}
+
+	void assign(Lit a, CRef reason)
+	{
+		assert(!value_[a] && !value_[a.neg()]);
+		value_[a] = 1;
+		reason_[a.var()] = reason;
+		trail_pos_[a.var()] = trail_.size();
+		trail_.push_back(a);
+	}
+
+	// process watches of x (which became true), only of core or non-core
+	// clauses. Returns conflicting clause if any.
+	CRef visit(Lit x, bool core)
+	{
+		auto &ws = watches_[x.neg()];
+		size_t j = 0;
+		for (size_t i = 0; i < ws.size(); ++i)
+		{
+			CRef ci = ws[i];
+			Clause &c = clauses_[ci];
+			if (c.has_flag(Flag::core) != core)
+			{
+				ws[j++] = ci;
+				continue;
+			}
+			if (c[0] == x.neg())
+				std::swap(c[0], c[1]);
+			assert(c[1] == x.neg());
+
+			if (value_[c[0]])
+			{
+				ws[j++] = ci;
+				continue;
+			}
+
+			bool moved = false;
+			for (size_t k = 2; k < c.size(); ++k)
+				if (!value_[c[k].neg()])
+				{
+					std::swap(c[1], c[k]);
+					watches_[c[1]].push_back(ci);
+					moved = true;
+					break;
+				}
+			if (moved)
+				continue;
+
+			ws[j++] = ci;
+			if (value_[c[0].neg()])
+			{
+				for (++i; i < ws.size(); ++i)
+					ws[j++] = ws[i];
+				ws.resize(j);
+				return ci;
+			}
+			assign(c[0], ci);
+		}
+		ws.resize(j);
+		return CRef::undef();
+	}
+
+	// unit propagation, using non-core clauses only if core clauses are
+	// exhausted. Returns conflicting clause if any.
+	CRef propagate()
+	{
+		while (true)
+		{
+			while (head_core_ < trail_.size())
+				if (CRef c = visit(trail_[head_core_++], true); c.proper())
+					return c;
+			if (head_all_ == trail_.size())
+				return CRef::undef();
+			if (CRef c = visit(trail_[head_all_++], false); c.proper())
+				return c;
+		}
+	}
+
+	void unassign_to(size_t pos)
+	{
+		while (trail_.size() > pos)
+		{
+			Lit a = trail_.back();
+			trail_.pop_back();
+			value_[a] = 0;
+			reason_[a.var()] = CRef::undef();
+			core_unit_[a.var()] = 0;
+		}
+	}
+
+	// remove temporary assignments
+	void backtrack()
+	{
+		unassign_to(top_);
+		head_core_ = head_all_ = top_;
+	}
+
+	// propagate at top-level, recording conflicts
+	void propagate_top()
+	{
+		assert(trail_.size() >= top_);
+		if (CRef c = propagate(); c.proper())
+			conflict_ = c;
+		top_ = trail_.size();
+	}
+
+	// add a clause to the watches (or trail) at top-level
+	void attach(CRef ci)
+	{
+		assert(trail_.size() == top_);
+		Clause &c = clauses_[ci];
+
+		// true literals first, then unassigned, then false
+		auto rank = [&](Lit a) { return value_[a] ? 0 : value_[a.neg()] ? 2 : 1; };
+		std::stable_sort(c.begin(), c.end(),
+		                 [&](Lit a, Lit b) { return rank(a) < rank(b); });
+
+		if (c.size() == 0 || value_[c[0].neg()])
+		{
+			conflict_ = ci;
+			return;
+		}
+		if (c.size() == 1)
+		{
+			if (!value_[c[0]])
+				assign(c[0], ci);
+		}
+		else
+		{
+			watches_[c[0]].push_back(ci);
+			watches_[c[1]].push_back(ci);
+			if (!value_[c[0]] && value_[c[1].neg()])
+				assign(c[0], ci);
+		}
+		propagate_top();
+	}
+
+	void detach(CRef ci)
+	{
+		Clause const &c = clauses_[ci];
+		if (c.size() >= 2)
+			for (int k : {0, 1})
+				std::erase(watches_[c[k]], ci);
+	}
+
+	// position on the trail of the literal 'ci' is the reason for (if any)
+	std::optional<size_t> reason_pos(CRef ci)
+	{
+		Clause const &c = clauses_[ci];
+		if (c.size() == 0 || !value_[c[0]] || reason_[c[0].var()] != ci)
+			return std::nullopt;
+		return trail_pos_[c[0].var()];
+	}
+
+	void mark_core(CRef ci) { clauses_[ci].set_flag(Flag::core); }
+
+	// mark the derivation of a top-level assignment as core
+	void mark_core_unit(int v)
+	{
+		std::vector<int> todo = {v};
+		while (!todo.empty())
+		{
+			int w = todo.back();
+			todo.pop_back();
+			if (core_unit_[w])
+				continue;
+			core_unit_[w] = 1;
+			CRef r = reason_[w];
+			assert(r.proper());
+			mark_core(r);
+			for (Lit a : clauses_[r].lits())
+				if (a.var() != w)
+					todo.push_back(a.var());
+		}
+	}
+
+	// mark everything involved in a conflict as core
+	void analyze(CRef confl)
+	{
+		std::vector<int> touched;
+		size_t pending = 0;
+		auto handle = [&](Lit a) {
+			int v = a.var();
+			if (seen_[v])
+				return;
+			seen_[v] = 1;
+			touched.push_back(v);
+			if (trail_pos_[v] < top_)
+				mark_core_unit(v);
+			else if (reason_[v].proper())
+				++pending;
+		};
+
+		mark_core(confl);
+		for (Lit a : clauses_[confl].lits())
+			handle(a);
+		for (size_t i = trail_.size(); pending;)
+		{
+			Lit a = trail_[--i];
+			if (!seen_[a.var()] || !reason_[a.var()].proper())
+				continue;
+			--pending;
+			CRef r = reason_[a.var()];
+			mark_core(r);
+			for (Lit b : clauses_[r].lits())
+				if (b.var() != a.var())
+					handle(b);
+		}
+		for (int v : touched)
+			seen_[v] = 0;
+	}
+
+	// check that a clause is RUP, marking the involved clauses as core
+	bool rup(std::span<const Lit> lits)
+	{
+		assert(trail_.size() == top_);
+		for (Lit a : lits)
+			ensure_var(a);
+		for (Lit a : lits)
+			if (value_[a])
+			{
+				mark_core_unit(a.var());
+				return true;
+			}
+		for (Lit a : lits)
+			if (!value_[a.neg()])
+				assign(a.neg(), CRef::undef());
+
+		CRef confl = propagate();
+		if (confl.proper())
+			analyze(confl);
+		backtrack();
+		return confl.proper();
+	}
+
+	// check that a clause is RAT on the pivot 'p'. The clause itself is
+	// sorted and reordered by the watches, so 'p' has to be given explicitly.
+	bool rat(CRef ci, Lit p)
+	{
+		auto const &lemma = clauses_[ci];
+		if (lemma.size() == 0 || !lemma.contains(p))
+			return false;
+
+		stack_.clear();
+		for (auto [cj, cl] : clauses_.enumerate())
+			if (cj != ci && cl.contains(p.neg()))
+				stack_.push_back(cj);
+
+		for (CRef cj : stack_)
+		{
+			resolvent_.assign(lemma.begin(), lemma.end());
+			for (Lit a : clauses_[cj].lits())
+				if (a != p.neg())
+					resolvent_.push_back(a);
+			std::sort(resolvent_.begin(), resolvent_.end());
+			bool tautology = false;
+			for (size_t i = 1; i < resolvent_.size(); ++i)
+				if (resolvent_[i] == resolvent_[i - 1].neg())
+					tautology = true;
+			if (tautology)
+				continue;
+			if (!rup(resolvent_))
+				return false;
+			mark_core(cj);
+		}
+		return true;
+	}
+
+	CRef find(std::span<const Lit> lits)
+	{
+		auto [first, last] = index_.equal_range(clause_hash(lits));
+		for (auto it = first; it != last; ++it)
+		{
+			auto const &c = clauses_[it->second];
+			if (c.size() == lits.size() &&
+			    std::is_permutation(c.begin(), c.end(), lits.begin()))
+			{
+				CRef r = it->second;
+				index_.erase(it);
+				return r;
+			}
+		}
+		return CRef::undef();
+	}
+
+  public:
+	ProofCheckResult result;
+
+	explicit DratChecker(ClauseStorage const &cnf)
+	{
+		auto lits = std::vector<Lit>();
+		for (auto &cl : cnf.all())
+		{
+			lits.assign(cl.begin(), cl.end());
+			if (!normalize_sorted(lits))
+				continue;
+			for (Lit a : lits)
+				ensure_var(a);
+			CRef ci = clauses_.add_clause(lits, Color::blue);
+			index_.emplace(clause_hash(lits), ci);
+			if (!conflict_.proper())
+				attach(ci);
+		}
+	}
+
+	// forward pass up to the first top-level conflict
+	void read(std::string const &proof_file)
+	{
+		auto parser = ProofParser(proof_file, false);
+		auto step = ProofStep();
+		while (!conflict_.proper() && parser.next(step))
+		{
+			Lit pivot = step.lits.empty() ? Lit::undef() : step.lits[0];
+			if (!normalize_sorted(step.lits))
+				continue; // tautologies are useless (and trivially valid)
+			for (Lit a : step.lits)
+				ensure_var(a);
+
+			if (!step.del)
+			{
+				result.lemmas += 1;
+				if (step.lits.empty())
+				{
+					result.message = fmt::format(
+					    "empty clause (lemma {}) is not RUP", result.lemmas);
+					return;
+				}
+				CRef ci = clauses_.add_clause(step.lits, Color::blue);
+				index_.emplace(clause_hash(step.lits), ci);
+				steps_.push_back({ci, false, pivot});
+				attach(ci);
+				continue;
+			}
+
+			CRef ci = find(step.lits);
+			if (!ci.proper() || step.lits.size() == 1 || reason_pos(ci) ||
+			    ci == conflict_)
+			{
+				if (ci.proper())
+					index_.emplace(clause_hash(step.lits), ci);
+				result.ignored += 1;
+				continue;
+			}
+			result.deletions += 1;
+			detach(ci);
+			clauses_[ci].set_color(Color::black);
+			steps_.push_back({ci, true, Lit::undef()});
+		}
+
+		if (!conflict_.proper())
+			result.message = "proof does not derive a conflict";
+	}
+
+	// backward pass, checking all core lemmas
+	void check()
+	{
+		if (!result.message.empty())
+			return;
+		assert(conflict_.proper());
+		index_.clear();
+		analyze(conflict_);
+
+		for (size_t i = steps_.size(); i--;)
+		{
+			auto [ci, del, pivot] = steps_[i];
+			if (del)
+			{
+				clauses_[ci].set_color(Color::blue);
+				attach(ci);
+				continue;
+			}
+
+			// remove the lemma, including everything propagated from it.
+			// (the last lemma might be part of an incomplete propagation)
+			detach(ci);
+			clauses_[ci].set_color(Color::black);
+			if (auto pos = reason_pos(ci); pos || conflict_.proper())
+			{
+				unassign_to(pos ? *pos : trail_.size());
+				head_core_ = head_all_ = 0;
+				top_ = trail_.size();
+				conflict_ = CRef::undef();
+				propagate_top();
+				assert(!conflict_.proper());
+			}
+
+			if (!clauses_[ci].has_flag(Flag::core))
+				continue;
+			result.checked += 1;
+			if (rup(clauses_[ci].lits()))
+				continue;
+			result.rat += 1;
+			if (!rat(ci, pivot))
+			{
+				result.message = fmt::format("lemma {} ({}) is neither RUP nor RAT",
+				                             i + 1, clauses_[ci]);
+				return;
+			}
+		}
+		result.valid = true;
+	}
+};
+
+class LratChecker
+{
+	ClauseStorage clauses_;
+	std::unordered_map<int64_t, CRef> ids_;
+	size_t garbage_ = 0; // deleted clauses still in storage
+	int64_t last_id_ = 0;
+
+	std::vector<uint8_t> value_; // indexed by literal
+	std::vector<Lit> assigned_;
+
+	void ensure_var(Lit a)
+	{
+		if ((size_t)a >= value_.size())
+			value_.resize(2 * (a.var() + 1));
+	}
+
+	void set(Lit a)
+	{
+		value_[a] = 1;
+		assigned_.push_back(a);
+	}
+
+	void reset(size_t n)
+	{
+		while (assigned_.size() > n)
+		{
+			value_[assigned_.back()] = 0;
+			assigned_.pop_back();
+		}
+	}
+
+	// run hints as unit propagations until a conflict is found
+	std::string run_hints(std::span<const int64_t> hints)
+	{
+		for (int64_t h : hints)
+		{
+			auto it = ids_.find(h);
+			if (it == ids_.end())
+				return fmt::format("hint {} does not exist", h);
+			Lit unit = Lit::undef();
+			int unassigned = 0;
+			for (Lit a : clauses_[it->second].lits())
+				if (value_[a])
+					return fmt::format("hint {} is satisfied", h);
+				else if (!value_[a.neg()])
+				{
+					unit = a;
+					++unassigned;
+				}
+			if (unassigned == 0)
+				return "";
+			if (unassigned > 1)
+				return fmt::format("hint {} is not unit", h);
+			set(unit);
+		}
+		return "no conflict";
+	}
+
+	std::string check_lemma(ProofStep const &step)
+	{
+		for (Lit a : step.lits)
+			ensure_var(a);
+		reset(0);
+		for (Lit a : step.lits)
+		{
+			if (value_[a]) // tautology
+				return "";
+			if (!value_[a.neg()])
+				set(a.neg());
+		}
+
+		// RUP part
+		auto hints = std::span(step.hints);
+		auto rat_begin = std::find_if(hints.begin(), hints.end(),
+		                              [](int64_t h) { return h < 0; });
+		auto msg = run_hints(hints.subspan(0, rat_begin - hints.begin()));
+		if (msg != "no conflict")
+			return msg;
+		if (step.lits.empty())
+			return "no conflict";
+
+		// RAT part: every clause containing the negated pivot needs hints,
+		// unless the resolvent is a tautology
+		result.rat += 1;
+		auto groups = std::unordered_map<int64_t, std::span<const int64_t>>();
+		for (auto it = rat_begin; it != hints.end();)
+		{
+			auto end = std::find_if(it + 1, hints.end(),
+			                        [](int64_t h) { return h < 0; });
+			groups[-*it] = std::span(it + 1, end);
+			it = end;
+		}
+		Lit p = step.lits[0];
+		size_t base = assigned_.size();
+		for (auto &[id, ci] : ids_)
+		{
+			auto const &cl = clauses_[ci];
+			if (!cl.contains(p.neg()))
+				continue;
+			if (std::any_of(cl.begin(), cl.end(),
+			                [&](Lit a) { return a != p.neg() && value_[a]; }))
+				continue;
+			auto g = groups.find(id);
+			if (g == groups.end())
+				return fmt::format("RAT candidate {} has no hints", id);
+			for (Lit a : cl)
+				if (a != p.neg() && !value_[a.neg()])
+					set(a.neg());
+			if (auto m = run_hints(g->second); !m.empty())
+				return fmt::format("RAT candidate {}: {}", id, m);
+			reset(base);
+		}
+		return "";
+	}
+
+	void compact()
+	{
+		auto old = std::move(clauses_);
+		clauses_ = ClauseStorage();
+		for (auto &[id, ci] : ids_)
+			ci = clauses_.add_clause(old[ci].lits(), Color::blue);
+		garbage_ = 0;
+	}
+
+  public:
+	ProofCheckResult result;
+
+	explicit LratChecker(ClauseStorage const &cnf)
+	{
+		for (auto &cl : cnf.all())
+		{
+			for (Lit a : cl)
+				ensure_var(a);
+			auto lits = std::vector<Lit>(cl.begin(), cl.end());
+			std::sort(lits.begin(), lits.end());
+			lits.erase(std::unique(lits.begin(), lits.end()), lits.end());
+			ids_[++last_id_] = clauses_.add_clause(lits, Color::blue);
+		}
+	}
+
+	void check(std::string const &proof_file)
+	{
+		auto parser = ProofParser(proof_file, true);
+		auto step = ProofStep();
+		while (parser.next(step))
+		{
+			if (step.del)
+			{
+				for (int64_t id : step.hints)
+				{
+					auto it = ids_.find(id);
+					if (it == ids_.end())
+					{
+						result.ignored += 1;
+						continue;
+					}
+					clauses_[it->second].set_color(Color::black);
+					ids_.erase(it);
+					result.deletions += 1;
+					garbage_ += 1;
+				}
+				if (garbage_ > ids_.size())
+					compact();
+				continue;
+			}
+
+			result.lemmas += 1;
+			result.checked += 1;
+			if (step.id <= last_id_)
+			{
+				result.message =
+				    fmt::format("lemma ID {} is not increasing", step.id);
+				return;
+			}
+			if (auto msg = check_lemma(step); !msg.empty())
+			{
+				result.message = fmt::format("lemma {}: {}", step.id, msg);
+				return;
+			}
+			if (step.lits.empty())
+			{
+				result.valid = true;
+				return;
+			}
+			last_id_ = step.id;
+			std::sort(step.lits.begin(), step.lits.end());
+			step.lits.erase(std::unique(step.lits.begin(), step.lits.end()),
+			                step.lits.end());
+			if (step.lits.size() > Clause::max_size())
+				throw std::runtime_error("clause in proof is too long");
+			ids_[step.id] = clauses_.add_clause(step.lits, Color::blue);
+		}
+		result.message = "proof does not contain the empty clause";
+	}
+};
+
+} // namespace
+
+ProofCheckResult check_drat_proof(ClauseStorage const &cnf,
+                                  std::string const &proof_file)
+{
+	auto log = util::Logger("proof");
+	util::Stopwatch sw;
+	sw.start();
+	auto checker = DratChecker(cnf);
+	checker.read(proof_file);
+	log.info("read {} lemmas and {} deletions in {:.2f}s",
+	         checker.result.lemmas, checker.result.deletions, sw.secs());
+	checker.check();
+	log.info("checked {} core lemmas ({} RAT) in {:.2f}s",
+	         checker.result.checked, checker.result.rat, sw.secs());
+	return checker.result;
+}
+
+ProofCheckResult check_lrat_proof(ClauseStorage const &cnf,
+                                  std::string const &proof_file)
+{
+	auto log = util::Logger("proof");
+	util::Stopwatch sw;
+	sw.start();
+	auto checker = LratChecker(cnf);
+	checker.check(proof_file);
+	log.info("checked {} lemmas ({} RAT) in {:.2f}s", checker.result.checked,
+	         checker.result.rat, sw.secs());
+	return checker.result;
+}
+
+} // namespace dawn
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "sat/clause.h"
+#include <cstdint>
+#include <string>
+
+namespace dawn {
+
+struct ProofCheckResult
+{
+	bool valid = false;
+	std::string message; // reason if not valid
+
+	int64_t lemmas = 0;    // number of lemmas in the proof (up to the conflict)
+	int64_t checked = 0;   // number of lemmas actually checked
+	int64_t rat = 0;       // lemmas that needed the RAT check
+	int64_t deletions = 0; // deletions performed
+	int64_t ignored = 0;   // deletions of units/reasons/unknown clauses
+};
+
+// Backward DRAT checking: lemmas are added (and deleted) until a top-level
+// conflict is found. Then they are removed again in reverse order, checking
+// only those that were needed to derive the conflict (or later lemmas).
+//   * propagation prefers clauses already known to be needed ("core-first"),
+//     which tends to keep the set of checked lemmas small
+//   * deletion of unit clauses and of reasons of top-level assignments is
+//     ignored (same as drat-trim)
+//   * the proof is streamed (binary or text, possibly compressed), only the
+//     clauses themselves are kept in memory
+ProofCheckResult check_drat_proof(ClauseStorage const &cnf,
+                                  std::string const &proof_file);
+
+// Forward LRAT checking: every lemma is verified by replaying its hints, so
+// no search is needed at all. Original clauses are numbered 1, 2, ... in
+// order of 'cnf'.
+ProofCheckResult check_lrat_proof(ClauseStorage const &cnf,
+                                  std::string const &proof_file);
+
+} // namespace dawn
@@ -0,0 +1,39 @@
+#pragma once
+
+// internal helpers shared by the proof writers (DRAT/LRAT) and the checker,
+// so that both sides agree on the exact encoding
+
+#include "sat/clause.h"
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace dawn {
+
+// order-independent hash of a clause (without duplicate literals)
+inline uint64_t clause_hash(std::span<const Lit> lits)
+{
+	uint64_t h = 0;
+	for (Lit a : lits)
+	{
+		// splitmix64 finalizer
+		uint64_t x = (uint64_t)(uint32_t)a + 0x9e3779b97f4a7c15;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+		h += x ^ (x >> 31);
+	}
+	return h;
+}
+
+// 7 bits per byte, least significant first (as in binary DRAT/LRAT)
+inline void put_varint(std::string &out, uint64_t x)
+{
+	while (x > 127)
+	{
+		out.push_back((char)((x & 127) | 128));
+		x >>= 7;
+	}
+	out.push_back((char)x);
+}
+
+} // namespace dawn
@@ -45,6 +45,7 @@ void dawn::PropEngine::propagate_binary(Lit x, Reason r)
 	assign.set(x);
 	trail_.push_back(x);
 	assign_level[x.var()] = (int)mark_.size();
+	assign_time[x.var()] = analyzed_;
 	reason[x.var()] = r;
 
 	while (pos != trail_.size())
@@ -74,6 +75,7 @@ void dawn::PropEngine::propagate_binary(Lit x, Reason r)
 				assign.set(z);
 				trail_.push_back(z);
 				assign_level[z.var()] = (int)mark_.size();
+				assign_time[z.var()] = analyzed_;
 				reason[z.var()] = Reason(y.neg());
 				stats.nBinProps += 1;
 			}
@@ -83,7 +85,8 @@ void dawn::PropEngine::propagate_binary(Lit x, Reason r)
 
 dawn::PropEngine::PropEngine(Cnf const &cnf)
     : watches(cnf.var_count() * 2), reason(cnf.var_count()),
-      assign_level(cnf.var_count()), assign(cnf.var_count())
+      assign_level(cnf.var_count()), assign_time(cnf.var_count()),
+      assign(cnf.var_count())
 {
 	// empty clause -> don't bother doing anything
 	if (cnf.contradiction)
@@ -104,12 +107,92 @@ dawn::PropEngine::PropEngine(Cnf const &cnf)
 		watches[c[1]].push_back(i);
 	}
 
+	// attach XORs, each with its reason clause
+	if (!cnf.xors.empty())
+		xor_watches_.resize(cnf.var_count());
+	for (auto const &x : cnf.xors)
+	{
+		assert(x.vars.size() >= 3);
+		std::vector<Lit> lits;
+		for (int v : x.vars)
+			lits.push_back(Lit(v, false));
+		xor_watches_[x.vars[0]].push_back((int)xors_.size());
+		xor_watches_[x.vars[1]].push_back((int)xors_.size());
+		CRef reason = clauses.add_clause(lits, Color::black);
+		xors_.push_back({x.vars, x.rhs, reason});
+	}
+
 	// propagate unary clauses
 	for (auto l : cnf.units)
 		if (propagate(l) == -1)
 			return;
 }
 
+bool dawn::PropEngine::propagate_xors(int v)
+{
+	auto assigned = [&](int w) {
+		return assign[Lit(w, false)] || assign[Lit(w, true)];
+	};
+
+	auto &ws = xor_watches_[v];
+	for (size_t wi = 0; wi < ws.size(); ++wi)
+	{
+		Xor &x = xors_[ws[wi]];
+		auto &vars = x.vars;
+
+		// move v to vars[1] (so that vars[0] is the potentially propagated one)
+		if (vars[0] == v)
+			std::swap(vars[0], vars[1]);
+		assert(vars[1] == v);
+
+		// unassigned variable in the tail -> move watch
+		for (size_t i = 2; i < vars.size(); ++i)
+			if (!assigned(vars[i]))
+			{
+				std::swap(vars[1], vars[i]);
+				xor_watches_[vars[1]].push_back(ws[wi]);
+				ws[wi] = ws.back();
+				--wi;
+				ws.pop_back();
+				goto next_watch;
+			}
+
+		// everything except vars[0] is assigned -> it has to be 'a'
+		{
+			bool parity = x.rhs;
+			for (size_t i = 1; i < vars.size(); ++i)
+				parity ^= assign[Lit(vars[i], false)];
+			Lit a = Lit(vars[0], !parity);
+			if (assign[a])
+				continue;
+
+			// explanation: 'a', or one of the others is different
+			auto explain = [&](std::span<Lit> cl) {
+				cl[0] = a;
+				for (size_t i = 1; i < vars.size(); ++i)
+					cl[i] = Lit(vars[i], assign[Lit(vars[i], false)]);
+			};
+			if (assign[a.neg()])
+			{
+				stats.nXorConfls += 1;
+				conflict = true;
+				assert(conflict_clause.empty());
+				conflict_clause.resize(vars.size());
+				explain(conflict_clause);
+				return false;
+			}
+			stats.nXorProps += 1;
+			explain(clauses[x.reason].lits());
+			propagate_binary(a, Reason(x.reason));
+			if (conflict)
+				return false;
+		}
+
+	next_watch:;
+	}
+	return true;
+}
+
 int dawn::PropEngine::propagate(Lit x, Reason r)
 {
 	assert(!conflict);
@@ -198,6 +281,9 @@ int dawn::PropEngine::propagate(Lit x, Reason r)
 
 		next_watch:;
 		}
+
+		if (!xors_.empty() && !propagate_xors(y.var()))
+			return -1;
 	}
 	return (int)trail_.size() - startPos;
 }
@@ -252,8 +338,9 @@ int PropEngine::probe_neg(std::span<const Lit> xs, Lit pivot)
 	return res;
 }
 
-void PropEngine::analyze_conflict(std::vector<Lit> &learnt,
-                                  ActivityHeap *activity_heap, int otf)
+template <class Queue>
+void PropEngine::analyze_conflict(std::vector<Lit> &learnt, Queue *queue,
+                                  int otf)
 {
 	assert(conflict);
 	assert(!conflict_clause.empty());
@@ -261,6 +348,7 @@ void PropEngine::analyze_conflict(std::vector<Lit> &learnt,
 	seen.clear();
 	learnt.resize(0);
 	int pending = 0; // number of pending resolutions
+	analyzed_ += 1;
 
 	// NOTE: On the reason side, 'seen' marks variables that are already
 	//       present in the learnt clause, to avoid duplicates. On the conflict
@@ -272,8 +360,8 @@ void PropEngine::analyze_conflict(std::vector<Lit> &learnt,
 		if (!seen.add(l.var()) || assign_level[l.var()] == 0)
 			return;
 
-		if (activity_heap)
-			activity_heap->bump_variable_activity(l.var());
+		if (queue)
+			queue->bump_variable_activity(l.var());
 		if (assign_level[l.var()] == level())
 			pending += 1;
 		else
@@ -318,8 +406,8 @@ void PropEngine::analyze_conflict(std::vector<Lit> &learnt,
 			assert(false);
 	}
 
-	if (activity_heap)
-		activity_heap->decay_variable_activity();
+	if (queue)
+		queue->decay_variable_activity();
 
 	std::sort(learnt.begin(), learnt.end(), [&](Lit a, Lit b) {
 		return assign_level[a.var()] > assign_level[b.var()];
@@ -327,11 +415,75 @@ void PropEngine::analyze_conflict(std::vector<Lit> &learnt,
 	if (otf >= 1)
 		shorten_learnt(learnt, otf >= 2);
 
+	// reason side: vars in the reasons of the learnt clause which were not
+	// part of the conflict analysis (only used by the LrbQueue)
+	if constexpr (requires { queue->bump_reason_side(0); })
+	{
+		assert(queue);
+		auto bump = [&](Lit b) {
+			if (assign_level[b.var()] != 0 && seen.add(b.var()))
+				queue->bump_reason_side(b.var());
+		};
+		for (Lit a : learnt)
+		{
+			Reason r = reason[a.var()];
+			if (r.isBinary())
+				bump(r.lit());
+			else if (r.isLong())
+			{
+				const Clause &cl = clauses[r.cref()];
+				for (int i = 1; i < cl.size(); ++i)
+					bump(cl[i]);
+			}
+		}
+	}
+
 	stats.nLitsLearnt += learnt.size();
 	stats.learn_events.push_back(
 	    {.depth = level(), .size = (int)learnt.size()});
 }
 
+template void PropEngine::analyze_conflict(std::vector<Lit> &, ActivityHeap *,
+                                           int);
+template void PropEngine::analyze_conflict(std::vector<Lit> &, VmtfQueue *,
+                                           int);
+template void PropEngine::analyze_conflict(std::vector<Lit> &, LrbQueue *,
+                                           int);
+
+void dawn::PropEngine::analyze_final(Lit a, std::vector<Lit> &failed)
+{
+	assert(assign[a.neg()]);
+	failed.assign({a});
+	if (assign_level[a.var()] == 0)
+		return;
+
+	seen.clear();
+	seen.add(a.var());
+	for (int i = (int)trail_.size() - 1; i >= mark_[0]; --i)
+	{
+		Lit x = trail_[i];
+		if (!seen[x.var()])
+			continue;
+
+		auto handle = [&](Lit b) {
+			if (assign_level[b.var()] != 0)
+				seen.add(b.var());
+		};
+		Reason r = reason[x.var()];
+		if (r.isUndef())
+			failed.push_back(x);
+		else if (r.isBinary())
+			handle(r.lit());
+		else
+		{
+			const Clause &cl = clauses[r.cref()];
+			assert(cl[0] == x);
+			for (int j = 1; j < cl.size(); ++j)
+				handle(cl[j]);
+		}
+	}
+}
+
 void dawn::PropEngine::shorten_learnt(std::vector<Lit> &learnt, bool recursive)
 {
 	int j = 1;
@@ -343,6 +495,70 @@ void dawn::PropEngine::shorten_learnt(std::vector<Lit> &learnt, bool recursive)
 	learnt.resize(j);
 }
 
+void dawn::PropEngine::learnt_chain(std::span<const Lit> learnt,
+                                    std::vector<Lit> &chain)
+{
+	assert(conflict);
+	assert(!conflict_clause.empty());
+
+	// NOTE: 'seen' marks variables of the learnt clause (i.e., assumptions),
+	//       'explained' marks variables whose reason is needed.
+	seen.clear();
+	explained.clear();
+	for (Lit l : learnt)
+		seen.add(l.var());
+	int pending = 0;
+	auto handle = [&](Lit l) {
+		if (assign_level[l.var()] == 0 || seen[l.var()])
+			return;
+		if (explained.add(l.var()))
+			pending += 1;
+	};
+
+	for (Lit l : conflict_clause)
+		handle(l);
+	std::vector<Lit> used; // in reverse order of the trail
+	for (auto it = trail_.rbegin(); pending; ++it)
+	{
+		Lit a = *it;
+		if (!explained[a.var()])
+			continue;
+		pending -= 1;
+		used.push_back(a);
+
+		Reason r = reason[a.var()];
+		if (r.isBinary())
+			handle(r.lit());
+		else if (r.isLong())
+		{
+			const Clause &cl = clauses[r.cref()];
+			assert(cl[0] == a);
+			for (int i = 1; i < cl.size(); ++i)
+				handle(cl[i]);
+		}
+		else
+			assert(false);
+	}
+
+	for (auto it = used.rbegin(); it != used.rend(); ++it)
+	{
+		Reason r = reason[it->var()];
+		if (r.isBinary())
+		{
+			chain.push_back(*it);
+			chain.push_back(r.lit());
+		}
+		else
+		{
+			auto lits = clauses[r.cref()].lits();
+			chain.insert(chain.end(), lits.begin(), lits.end());
+		}
+		chain.push_back(Lit::undef());
+	}
+	chain.insert(chain.end(), conflict_clause.begin(), conflict_clause.end());
+	chain.push_back(Lit::undef());
+}
+
 int dawn::PropEngine::backtrack_level(std::span<const Lit> learnt) const
 {
 	assert(!learnt.empty());
@@ -352,6 +568,16 @@ int dawn::PropEngine::backtrack_level(std::span<const Lit> learnt) const
 	return assign_level[learnt[1].var()];
 }
 
+int dawn::PropEngine::lbd(std::span<const Lit> cl)
+{
+	levels.clear();
+	int r = 0;
+	for (Lit a : cl)
+		if (levels.add(assign_level[a.var()]))
+			++r;
+	return r;
+}
+
 void dawn::PropEngine::print_trail() const
 {
 	for (int l = 0; l <= level(); ++l)
@@ -2,6 +2,8 @@
 
 #include "sat/activity_heap.h"
 #include "sat/cnf.h"
+#include "sat/lrb.h"
+#include "sat/vmtf.h"
 #include "util/bit_vector.h"
 #include <cassert>
 #include <optional>
@@ -66,7 +68,9 @@ struct Reason
 //   * merge this (again) with PropEngineLight
 class PropEngine
 {
-	util::bit_set seen; // temporary during conflict analysis
+	util::bit_set seen;      // temporary during conflict analysis
+	util::bit_set explained; // temporary for 'learnt_chain'
+	util::bit_set levels;    // temporary for 'lbd'
 
 	std::vector<Lit> trail_; // assigned variables
 	std::vector<int> mark_;  // indices into trail
@@ -76,9 +80,28 @@ class PropEngine
 
 	std::vector<Reason> reason; // only valid for assigned vars
 	std::vector<int> assign_level;
+	std::vector<int64_t> assign_time; // value of 'analyzed_' when assigned
+	int64_t analyzed_ = 0;            // number of conflicts analyzed
 
 	std::vector<Lit> conflict_clause;
 
+	// XOR constraints (see 'Cnf::xors'), watched by their first two variables.
+	// Each has an unattached (black) clause in 'clauses', which is overwritten
+	// with the explanation whenever the XOR propagates, so that it can be used
+	// as a regular reason. That is fine because an XOR can not propagate
+	// again before the variable it propagated is unassigned.
+	struct Xor
+	{
+		std::vector<int> vars;
+		bool rhs;
+		CRef reason;
+	};
+	std::vector<Xor> xors_;
+	std::vector<util::small_vector<int, 3>> xor_watches_; // by variable
+
+	// propagate XORs watched by (just assigned) 'v', false on conflict
+	bool propagate_xors(int v);
+
 	bool is_redundant(Lit lit, bool recursive); // helper for OTF strengthening
 	void propagate_binary(Lit x, Reason r); // set 'x' and propagate bin clauses
 
@@ -111,10 +134,12 @@ class PropEngine
 
 	// unroll assignments up to some level
 	//   - after unrolling, level() == l
-	//   - re-add freed vars to activity-heap (if activity_heap != null)
+	//   - re-add freed vars to the decision queue (ActivityHeap, VmtfQueue or
+	//     LrbQueue). If the queue supports it, it is also told how many
+	//     conflicts each var was assigned for.
 	void unroll(); // unroll one level
 	void unroll(int l);
-	void unroll(int l, ActivityHeap &activity_heap);
+	template <class Queue> void unroll(int l, Queue &queue);
 
 	// read-only view (into trail_) of assignments
 	std::span<const Lit> trail() const;      // all levels
@@ -144,11 +169,18 @@ class PropEngine
 	int probe_neg(std::span<const Lit> xs, Lit pivot);
 
 	// analyze conflict up to UIP, outputs learnt clause, does NOT unroll
-	//  - bumps activity of all involved variables (if activity_heap != null)
+	//  - bumps activity of all involved variables (if queue != null)
 	//  - learnt clause is ordered by level, such that learnt[0] is the UIP
 	//  - otf = 0 -> no strengthening, 1 -> basic, 2 -> recursive
-	void analyze_conflict(std::vector<Lit> &learnt, ActivityHeap *activity_heap,
-	                      int otf);
+	//  - Queue = ActivityHeap or VmtfQueue
+	template <class Queue>
+	void analyze_conflict(std::vector<Lit> &learnt, Queue *queue, int otf);
+
+	// assumptions responsible for 'a' being false, written to 'failed'
+	//   * all decisions on the trail are considered assumptions
+	//   * 'a' itself is included, so the result is just 'a' if it is false
+	//     at level 0
+	void analyze_final(Lit a, std::vector<Lit> &failed);
 
 	// otf strengthening of learnt clause
 	//   * only valid to do right after analyze_conflict(...)
@@ -156,9 +188,20 @@ class PropEngine
 	//   * keeps the order of remaining literals the same
 	void shorten_learnt(std::vector<Lit> &learnt, bool recursive);
 
+	// antecedents of a learnt clause (for LRAT proofs), i.e., the clauses which
+	// derive the conflict by unit propagation from the negation of 'learnt'
+	//   * only valid right after analyze_conflict(...), before unrolling
+	//   * appends clauses to 'chain' in order of propagation, each followed by
+	//     Lit::undef(), ending with the conflict clause itself
+	//   * level-0 assignments are not explained
+	void learnt_chain(std::span<const Lit> learnt, std::vector<Lit> &chain);
+
 	// determine backtrack level ( = level of learnt[1])
 	int backtrack_level(std::span<const Lit> cl) const;
 
+	// number of distinct decision levels in an (assigned) clause, aka 'glue'
+	int lbd(std::span<const Lit> cl);
+
 	// for debugging
 	void print_trail() const;
 
@@ -203,11 +246,17 @@ inline void PropEngine::unroll(int l)
 	mark_.resize(l);
 }
 
-inline void PropEngine::unroll(int l, ActivityHeap &activity_heap)
+template <class Queue> inline void PropEngine::unroll(int l, Queue &queue)
 {
 	assert(l < level());
 	for (int i = mark_[l]; i < (int)trail_.size(); ++i)
-		activity_heap.push(trail_[i].var());
+	{
+		int v = trail_[i].var();
+		if constexpr (requires { queue.unassign(v, int64_t{}); })
+			queue.unassign(v, analyzed_ - assign_time[v]);
+		else
+			queue.push(v);
+	}
 	unroll(l);
 }
 
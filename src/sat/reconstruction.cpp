@@ -1,6 +1,7 @@
 #include "sat/reconstruction.h"
 
 #include <cassert>
+#include <stdexcept>
 
 using namespace dawn;
 
@@ -16,6 +17,14 @@ Lit dawn::Reconstruction::to_outer(Lit a)
 	return to_outer_[a.var()] ^ a.sign();
 }
 
+Lit dawn::Reconstruction::outer(Lit a) const
+{
+	assert(a.proper());
+	if (a.var() < (int)to_outer_.size())
+		return to_outer_[a.var()] ^ a.sign();
+	return Lit(outer_var_count_ + (a.var() - (int)to_outer_.size()), a.sign());
+}
+
 dawn::Reconstruction::Reconstruction(int n) noexcept
     : outer_var_count_(n), orig_var_count_(n), to_outer_(n)
 {
@@ -93,10 +102,13 @@ Assignment dawn::Reconstruction::operator()(Assignment const &a) const
 {
 	assert(a.var_count() >= (int)to_outer_.size());
 
-	auto r = Assignment(outer_var_count_);
-	for (int i = 0; i < (int)to_outer_.size() * 2; ++i)
+	// inner variables that were added since the last renumbering are mapped
+	// as by 'outer()', so that their values are not lost
+	int extra = a.var_count() - (int)to_outer_.size();
+	auto r = Assignment(outer_var_count_ + extra);
+	for (int i = 0; i < a.var_count() * 2; ++i)
 		if (Lit x = Lit(i); a[x])
-			r.set(to_outer_[x.var()] ^ x.sign());
+			r.set(outer(x));
 	r.fix_unassigned();
 
 	std::vector<CRef> crefs;
@@ -108,6 +120,47 @@ Assignment dawn::Reconstruction::operator()(Assignment const &a) const
 	return r;
 }
 
+// layout: outer_var_count, orig_var_count, to_outer.size(), to_outer...,
+// followed by the raw clause storage of the rules
+std::vector<uint32_t> Reconstruction::serialize() const
+{
+	auto r = std::vector<uint32_t>{(uint32_t)outer_var_count_,
+	                               (uint32_t)orig_var_count_,
+	                               (uint32_t)to_outer_.size()};
+	for (Lit a : to_outer_)
+		r.push_back(a);
+	for (Lit a : rules_.raw())
+		r.push_back(a);
+	return r;
+}
+
+Reconstruction Reconstruction::deserialize(std::span<const uint32_t> data)
+{
+	auto malformed = [] {
+		return std::runtime_error("malformed reconstruction data");
+	};
+	if (data.size() < 3)
+		throw malformed();
+	auto r = Reconstruction(0);
+	r.outer_var_count_ = (int)data[0];
+	r.orig_var_count_ = (int)data[1];
+	size_t n = data[2];
+	if (r.outer_var_count_ < 0 || r.orig_var_count_ < 0 ||
+	    r.orig_var_count_ > r.outer_var_count_ || data.size() - 3 < n)
+		throw malformed();
+	for (size_t i = 0; i < n; ++i)
+	{
+		auto a = Lit(data[3 + i]);
+		if (!a.proper() || a.var() >= r.outer_var_count_)
+			throw malformed();
+		r.to_outer_.push_back(a);
+	}
+	auto rules = data.subspan(3 + n);
+	r.rules_.assign_raw({(Lit const *)rules.data(), rules.size()},
+	                    r.outer_var_count_);
+	return r;
+}
+
 size_t Reconstruction::memory_usage() const
 {
 	return rules_.memory_usage() + sizeof(Lit) * to_outer_.capacity();
@@ -2,6 +2,7 @@
 
 #include "sat/assignment.h"
 #include "sat/clause.h"
+#include <cstdint>
 #include <ranges>
 #include <span>
 #include <vector>
@@ -41,6 +42,15 @@ class Reconstruction
 	// original variable count. can not change.
 	int orig_var_count() const noexcept { return orig_var_count_; }
 
+	// variable count of the current (transformed) formula, i.e., solutions
+	// passed to 'operator()' need at least this many variables
+	int inner_var_count() const noexcept { return (int)to_outer_.size(); }
+
+	// map an inner literal to the outer numbering. For variables not seen so
+	// far, this returns what the lazy extension in 'add_rule' would assign.
+	// (used for proof logging, which is done in outer variables)
+	Lit outer(Lit a) const;
+
 	// "plug in an ansatz", where 'trans' is mapping from old vars to new vars.
 	// Does allow fixed and equivalent variables.
 	void renumber(std::span<const Lit> trans, int newVarCount);
@@ -60,9 +70,15 @@ class Reconstruction
 	// number of rules recorded so far.
 	size_t rule_count() const { return rules_.count(); }
 
-	// map inner solution to outer solution
+	// map inner solution to outer solution (inner variables not seen so far
+	// are mapped as by 'outer()')
 	Assignment operator()(Assignment const &) const;
 
+	// flat representation of the full state, used for caching/exporting
+	// simplified formulas. 'deserialize' throws on malformed data.
+	std::vector<uint32_t> serialize() const;
+	static Reconstruction deserialize(std::span<const uint32_t> data);
+
 	// bytes allocated on the heap (rules and renumbering arrays)
 	size_t memory_usage() const;
 };
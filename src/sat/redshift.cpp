@@ -42,6 +42,8 @@ class Redshift
 
 bool Redshift::is_blocked(Clause const &cl, Lit a) const
 {
+	if (sat.is_frozen(a.var()))
+		return false;
 	for (CRef i : occs[a.neg()])
 		if (sat.clauses[i].color() == Color::blue)
 			if (!is_resolvent_tautological_unsorted(cl, sat.clauses[i].lits()))
@@ -54,6 +56,8 @@ bool Redshift::is_blocked(Clause const &cl, Lit a) const
 
 bool Redshift::is_blocked_np(Lit a)
 {
+	if (sat.is_frozen(a.var()))
+		return false;
 	for (CRef i : occs[a.neg()])
 		if (sat.clauses[i].color() == Color::blue)
 			if (p.probe_neg(sat.clauses[i], a.neg()) != -1)
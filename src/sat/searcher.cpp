@@ -1,5 +1,8 @@
 #include "sat/searcher.h"
 
+#include "sat/proof.h"
+#include <algorithm>
+
 namespace dawn {
 
 namespace {
@@ -14,19 +17,19 @@ int luby(int i)
 		return luby(i - (1 << (31 - __builtin_clz(i))) + 1);
 }
 
-int restartSize(int iter, Searcher::Config const &config)
+int restartSize(int iter, RestartType type, int base, float mult)
 {
 	assert(iter >= 1);
-	switch (config.restart_type)
+	switch (type)
 	{
 	case RestartType::constant:
-		return config.restart_base;
+		return base;
 	case RestartType::linear:
-		return iter * config.restart_base;
+		return iter * base;
 	case RestartType::geometric:
-		return std::pow(config.restart_mult, iter - 1) * config.restart_base;
+		return std::pow(mult, iter - 1) * base;
 	case RestartType::luby:
-		return luby(iter) * config.restart_base;
+		return luby(iter) * base;
 	default:
 		assert(false);
 	}
@@ -35,26 +38,216 @@ int restartSize(int iter, Searcher::Config const &config)
 } // namespace
 
 Searcher::Searcher(Cnf const &cnf, Config const &config)
-    : p_(cnf), act_(cnf.var_count()), polarity_(cnf.var_count()),
-      config_(config)
+    : p_(cnf), act_(cnf.var_count()), vmtf_(cnf.var_count()),
+      lrb_(cnf.var_count()),
+      polarity_(cnf.var_count()), target_(cnf.var_count()),
+      best_(cnf.var_count()), proof_(cnf.proof), config_(config)
+{
+	if (proof_ || config_.phases)
+		for (int i = 0; i < cnf.var_count(); ++i)
+			outer_.push_back(cnf.reconstruction().outer(Lit(i, false)));
+
+	set_original_polarity(false);
+	target_ = polarity_;
+	best_ = polarity_;
+	if (config_.phases)
+		load_phases();
+
+	if (config_.modes)
+		set_mode();
+	else
+	{
+		act_.set_decay(config_.decay);
+		heuristic_ = config_.heuristic;
+	}
+
+	if (config_.on_model)
+	{
+		assert(!proof_);
+		in_projection_.resize(cnf.var_count());
+		for (int v : config_.projection)
+			in_projection_[v] = true;
+	}
+}
+
+void Searcher::set_mode()
 {
-	auto rng = std::default_random_engine(config.seed);
+	assert(config_.modes);
+	assert(p_.level() == 0);
+	stable_ = config_.modes->stable;
+	act_.set_decay(stable_ ? config_.stable_decay : config_.focused_decay);
+	iter_ = 0;
+
+	// NOTE: The heaps are left untouched while using VMTF (and vice versa),
+	//       so they still contain all unassigned variables when switching
+	//       back. Only the VMTF search cursor needs to be reset.
+	heuristic_ = stable_ ? Heuristic::vsids : config_.focused_heuristic;
+	if (heuristic_ == Heuristic::vmtf)
+		vmtf_.reset_search();
+}
+
+void Searcher::set_original_polarity(bool inverted)
+{
+	auto rng = std::default_random_engine(config_.seed);
 	std::uniform_int_distribution<int> dist(0, 1);
-	if (config_.starting_polarity == Polarity::random)
+	for (int i = 0; i < p_.var_count(); ++i)
+		switch (config_.starting_polarity)
+		{
+		case Polarity::random:
+			polarity_[i] = dist(rng) ^ inverted;
+			break;
+		case Polarity::negative:
+			polarity_[i] = inverted;
+			break;
+		case Polarity::positive:
+			polarity_[i] = !inverted;
+			break;
+		}
+}
+
+void Searcher::load_phases()
+{
+	assert(config_.phases);
+	auto &ph = *config_.phases;
+
+	// NOTE: polarity_[i] is the sign of the literal to branch on, i.e. true
+	//       means the variable is set to false
+	auto load = [&](std::vector<lbool> const &phases, util::bit_vector &out) {
+		for (int i = 0; i < p_.var_count(); ++i)
+		{
+			Lit a = outer_[i];
+			if (a.var() < (int)phases.size() && phases[a.var()] != lundef)
+				out[i] = (phases[a.var()] ^ a.sign()) == lfalse;
+		}
+	};
+	load(ph.saved, polarity_);
+	target_ = polarity_;
+	best_ = polarity_;
+	load(ph.target, target_);
+	load(ph.best, best_);
+	target_size_ = ph.target_size;
+	best_size_ = ph.best_size;
+}
+
+void Searcher::store_phases()
+{
+	assert(config_.phases);
+	auto &ph = *config_.phases;
+
+	auto store = [&](util::bit_vector const &in, std::vector<lbool> &phases) {
+		for (int i = 0; i < p_.var_count(); ++i)
+		{
+			Lit a = outer_[i];
+			if (a.var() >= (int)phases.size())
+				phases.resize(a.var() + 1, lundef);
+			phases[a.var()] = lbool(in[i] == a.sign());
+		}
+	};
+	store(polarity_, ph.saved);
+	store(target_, ph.target);
+	store(best_, ph.best);
+	ph.target_size = target_size_;
+	ph.best_size = best_size_;
+}
+
+void Searcher::update_target()
+{
+	// everything below the conflicting level is conflict-free
+	auto trail = p_.trail();
+	int64_t n = trail.size() - p_.trail(p_.level()).size();
+	if (n > target_size_)
 	{
-		for (int i = 0; i < cnf.var_count(); ++i)
-			polarity_[i] = dist(rng);
+		target_size_ = n;
+		for (Lit x : trail.subspan(0, n))
+			target_[x.var()] = x.sign();
 	}
-	else if (config_.starting_polarity == Polarity::negative)
+	if (n > best_size_)
 	{
-		for (int i = 0; i < cnf.var_count(); ++i)
-			polarity_[i] = false;
+		best_size_ = n;
+		for (Lit x : trail.subspan(0, n))
+			best_[x.var()] = x.sign();
+	}
+}
+
+void Searcher::rephase(Rephase r)
+{
+	assert(p_.level() == 0);
+	switch (r)
+	{
+	case Rephase::original:
+		set_original_polarity(false);
+		break;
+	case Rephase::inverted:
+		set_original_polarity(true);
+		break;
+	case Rephase::best:
+		polarity_ = best_;
+		best_size_ = 0;
+		break;
+	case Rephase::random: {
+		auto rng = std::default_random_engine(config_.seed +
+		                                      config_.phases->count);
+		std::uniform_int_distribution<int> dist(0, 1);
+		for (int i = 0; i < p_.var_count(); ++i)
+			polarity_[i] = dist(rng);
+		break;
+	}
+	case Rephase::walk:
+		assert(false);
+		break;
 	}
+	target_ = polarity_;
+	target_size_ = 0;
+}
+
+bool Searcher::interrupted(std::stop_token const &stoken) const
+{
+	return stoken.stop_requested() || (config_.terminate && config_.terminate());
+}
+
+RestartType Searcher::restart_type() const
+{
+	if (!config_.modes)
+		return config_.restart_type;
+	return stable_ ? RestartType::luby : RestartType::dynamic;
+}
+
+int Searcher::restart_base() const
+{
+	return config_.modes && stable_ ? config_.stable_restart_base
+	                                : config_.restart_base;
+}
+
+void Searcher::write_proof(char kind, std::span<const Lit> cl,
+                           std::span<const Lit> chain)
+{
+	proof_buf_.clear();
+	for (Lit a : cl)
+		proof_buf_.push_back(outer_[a.var()] ^ a.sign());
+	proof_chain_.clear();
+	for (Lit a : chain)
+		proof_chain_.push_back(a == Lit::undef() ? a
+		                                         : outer_[a.var()] ^ a.sign());
+	if (kind == 'a')
+		proof_->add(proof_buf_, proof_chain_);
 	else
+		proof_->del(proof_buf_);
+}
+
+void Searcher::unroll(int level)
+{
+	proj_next_ = 0;
+	switch (heuristic_)
 	{
-		assert(config_.starting_polarity == Polarity::positive);
-		for (int i = 0; i < cnf.var_count(); ++i)
-			polarity_[i] = true;
+	case Heuristic::vsids:
+		p_.unroll(level, act_);
+		break;
+	case Heuristic::vmtf:
+		p_.unroll(level, vmtf_);
+		break;
+	case Heuristic::lrb:
+		p_.unroll(level, lrb_);
+		break;
 	}
 }
 
@@ -64,18 +257,48 @@ Lit Searcher::choose_branch()
 	// int branch = p.unassignedVariable();
 	int branchVar = -1;
 
-	while (!act_.empty())
+	// projection variables come first (in fixed order). No dominator
+	// branching for them, as that might pick a non-projection literal.
+	auto proj = config_.projection;
+	while (proj_next_ < proj.size() &&
+	       (p_.assign[Lit(proj[proj_next_], false)] ||
+	        p_.assign[Lit(proj[proj_next_], true)]))
+		++proj_next_;
+	if (proj_next_ < proj.size())
 	{
-		int v = act_.pop();
-		if (p_.assign[Lit(v, false)] || p_.assign[Lit(v, true)])
-			continue;
+		int v = proj[proj_next_];
+		return Lit(v, polarity_[v]);
+	}
+
+	auto pop_unassigned = [&](auto &heap) {
+		while (!heap.empty())
+		{
+			int v = heap.pop();
+			if (p_.assign[Lit(v, false)] || p_.assign[Lit(v, true)])
+				continue;
+
+			// check the heap(very expensive, debug only)
+			// for (int i = 0; i < sat.varCount(); ++i)
+			//	assert(assign[Lit(i, false)] || assign[Lit(i, true)] ||
+			//	       sat.activity[i] <= sat.activity[v]);
 
-		// check the heap(very expensive, debug only)
-		// for (int i = 0; i < sat.varCount(); ++i)
-		//	assert(assign[Lit(i, false)] || assign[Lit(i, true)] ||
-		//	       sat.activity[i] <= sat.activity[v]);
+			return v;
+		}
+		return -1;
+	};
 
-		branchVar = v;
+	switch (heuristic_)
+	{
+	case Heuristic::vsids:
+		branchVar = pop_unassigned(act_);
+		break;
+	case Heuristic::vmtf:
+		branchVar = vmtf_.next([&](int v) {
+			return !p_.assign[Lit(v, false)] && !p_.assign[Lit(v, true)];
+		});
+		break;
+	case Heuristic::lrb:
+		branchVar = pop_unassigned(lrb_);
 		break;
 	}
 
@@ -83,7 +306,10 @@ Lit Searcher::choose_branch()
 	if (branchVar == -1)
 		return Lit::undef();
 
-	Lit branchLit = Lit(branchVar, polarity_[branchVar]);
+	bool target = config_.target_phases >= 2 ||
+	              (config_.target_phases == 1 && (!config_.modes || stable_));
+	Lit branchLit =
+	    Lit(branchVar, target ? target_[branchVar] : polarity_[branchVar]);
 
 	if (config_.branch_dom >= 1)
 	{
@@ -108,12 +334,23 @@ Lit Searcher::choose_branch()
 	return branchLit;
 }
 
-void Searcher::run_restart(Result &result, std::stop_token stoken)
+void Searcher::run_restart(Result &result, int64_t max_confls,
+                           std::stop_token stoken)
 {
-	int max_confls = restartSize(++iter_, config_);
+	++iter_;
+	auto type = restart_type();
+	bool dynamic = type == RestartType::dynamic;
+	if (!dynamic)
+		max_confls = restartSize(iter_, type, restart_base(),
+		                         config_.restart_mult);
 	int64_t nConfl = 0;
+	int64_t lastBlock = 0; // restart is postponed after blocking
 	assert(p_.level() == 0);
 
+	if (config_.phases && config_.rephase && config_.phases->remaining <= 0 &&
+	    config_.phases->peek() != Rephase::walk)
+		rephase(config_.phases->next());
+
 	while (true)
 	{
 		// handle conflicts
@@ -124,27 +361,75 @@ void Searcher::run_restart(Result &result, std::stop_token stoken)
 			// level 0 conflict -> UNSAT
 			if (p_.level() == 0)
 			{
+				if (proof_)
+					write_proof('a', {});
 				result.learnts.add_clause({}, Color::green);
 				return;
 			}
 			assert(p_.conflict && p_.level() > 0);
 
+			if (dynamic)
+			{
+				// NOTE: wait for the trail average to settle a bit
+				trail_size_.update(p_.trail().size());
+				if (nConfls_ >= 1000 &&
+				    p_.trail().size() > config_.restart_block * trail_size_())
+					lastBlock = nConfl;
+			}
+			nConfls_ += 1;
+			if (config_.modes)
+				config_.modes->remaining -= 1;
+			if (config_.phases)
+				config_.phases->remaining -= 1;
+			if (config_.target_phases || config_.phases)
+				update_target();
+
 			// analyze conflict
-			p_.analyze_conflict(buf_, &act_, config_.otf);
+			switch (heuristic_)
+			{
+			case Heuristic::vsids:
+				p_.analyze_conflict(buf_, &act_, config_.otf);
+				break;
+			case Heuristic::vmtf:
+				p_.analyze_conflict(buf_, &vmtf_, config_.otf);
+				break;
+			case Heuristic::lrb:
+				p_.analyze_conflict(buf_, &lrb_, config_.otf);
+				break;
+			}
 			assert(buf_.size() > 0);
 
+			int lbd = dynamic || config_.learn ? p_.lbd(buf_) : 0;
+			if (dynamic)
+			{
+				lbd_fast_.update(lbd);
+				lbd_slow_.update(lbd);
+			}
+
 			auto color = (int)buf_.size() <= config_.green_cutoff ? Color::green
 			                                                      : Color::red;
+			if (proof_)
+			{
+				chain_.clear();
+				if (proof_->wants_chain())
+					p_.learnt_chain(buf_, chain_);
+				write_proof('a', buf_, chain_);
+			}
 			if (color == Color::green)
 				result.learnts.add_clause(buf_, color);
+			if (config_.learn && (int)buf_.size() <= config_.learn_max_size &&
+			    lbd <= config_.learn_max_lbd)
+				config_.learn(buf_);
 			int backLevel = p_.backtrack_level(buf_);
 
 			// unroll to apropriate level and propagate new learnt clause
-			p_.unroll(backLevel, act_);
+			unroll(backLevel);
 
 			Reason r = Reason::undef();
 			if (buf_.size() > 1)
 				r = p_.add_clause(buf_, color);
+			if (proof_ && color == Color::red && r.isLong())
+				red_learnts_.push_back(r.cref());
 
 			// policy: do not save polarity in case of conflict
 			if (p_.propagate(buf_[0], r) != -1)
@@ -156,20 +441,56 @@ void Searcher::run_restart(Result &result, std::stop_token stoken)
 		// NOTE: by convention we handle all conflicts before returning, thus
 		//       max_confls can be (slightly) exceeded in case one conflict
 		//       leads to another immediately.
-		if (nConfl >= max_confls ||
-		    (nConfl % 16 == 0 && stoken.stop_requested()))
+		bool switch_mode = config_.modes && config_.modes->remaining <= 0;
+		if (nConfl >= max_confls || switch_mode ||
+		    (dynamic && nConfl - lastBlock >= restart_base() &&
+		     lbd_fast_() > config_.restart_margin * lbd_slow_()) ||
+		    (nConfl % 16 == 0 && interrupted(stoken)))
 		{
 			if (p_.level() > 0)
-				p_.unroll(0, act_);
+				unroll(0);
+			if (switch_mode)
+			{
+				config_.modes->next();
+				set_mode();
+			}
 			return;
 		}
 
+		// assumptions come first. Those which are already satisfied get an
+		// empty level, so that levels and assumptions stay in sync.
+		Lit branchLit = Lit::undef();
+		while (branchLit == Lit::undef() &&
+		       p_.level() < (int)config_.assumptions.size())
+		{
+			Lit a = config_.assumptions[p_.level()];
+			if (p_.assign[a.neg()])
+			{
+				result.failed.emplace();
+				p_.analyze_final(a, *result.failed);
+				if (p_.level() > 0)
+					unroll(0);
+				return;
+			}
+			if (p_.assign[a])
+				p_.mark();
+			else
+				branchLit = a;
+		}
+
 		// choose and propagate next branch
-		Lit branchLit = choose_branch();
+		if (branchLit == Lit::undef())
+			branchLit = choose_branch();
 		if (branchLit == Lit::undef())
 		{
-			result.solution = p_.assign;
-			return;
+			if (!config_.on_model)
+			{
+				result.solution = p_.assign;
+				return;
+			}
+			if (!block_solution(result))
+				return;
+			continue;
 		}
 		// TODO: question: should we set polarity in case of conflict?
 		//       (same applies when handling conflicts by adding new learnt)
@@ -179,25 +500,78 @@ void Searcher::run_restart(Result &result, std::stop_token stoken)
 	}
 }
 
+bool Searcher::block_solution(Result &result)
+{
+	// Negation of the decisions, highest level first (so that the first
+	// literal becomes unit). Decisions on assumptions are included, so the
+	// clause only holds under them. Other decisions are only included up to
+	// the first one outside of the projection.
+	buf_.clear();
+	int n_assumptions = (int)config_.assumptions.size();
+	bool exhausted = true;
+	for (int l = 1; l <= p_.level(); ++l)
+	{
+		if (p_.trail(l).empty()) // assumption that was already satisfied
+			continue;
+		Lit d = p_.trail(l)[0];
+		if (l > n_assumptions)
+		{
+			if (!config_.projection.empty() && !in_projection_[d.var()])
+				break;
+			exhausted = false;
+		}
+		buf_.push_back(d.neg());
+	}
+	std::reverse(buf_.begin(), buf_.end());
+
+	bool cont = config_.on_model(p_.assign);
+	result.learnts.add_clause(buf_, Color::blue);
+
+	// no decisions besides assumptions -> this was the last solution (under
+	// the assumptions). With assumptions, they fail in the next epoch.
+	if (exhausted)
+		enum_done_ = true;
+	else
+	{
+		unroll(p_.backtrack_level(buf_));
+		Reason r = Reason::undef();
+		if (buf_.size() > 1)
+			r = p_.add_clause(buf_, Color::blue);
+		p_.propagate(buf_[0], r);
+	}
+
+	if (!cont)
+		enum_done_ = true;
+	if (enum_done_ && p_.level() > 0)
+		unroll(0);
+	return !enum_done_;
+}
+
 Searcher::Result Searcher::run_epoch(int64_t max_confls, std::stop_token stoken)
 {
 	Result result;
 
 	p_.stats.clear();
 
-	while (p_.stats.nConfls() < max_confls && !stoken.stop_requested() &&
-	       !p_.conflict && !result.solution)
-		run_restart(result, stoken);
+	while (p_.stats.nConfls() < max_confls && !interrupted(stoken) &&
+	       !p_.conflict && !result.solution && !result.failed && !enum_done_)
+		run_restart(result, max_confls - p_.stats.nConfls(), stoken);
 
 	result.stats = p_.stats;
 	p_.stats.clear();
 
+	if (config_.phases)
+		store_phases();
+
 	// crude cleaning: remove everything not green
 	// TODO: while setting color=black does make PropEngine ignore the clauses,
 	// they are never actually removed?
 	for (Clause &cl : p_.clauses.all())
 		if (cl.color() == Color::red)
 			cl.set_color(Color::black);
+	for (CRef i : red_learnts_)
+		write_proof('d', p_.clauses[i].lits());
+	red_learnts_.clear();
 
 	return result;
 }
@@ -3,6 +3,8 @@
 #include "sat/activity_heap.h"
 #include "sat/propengine.h"
 #include "util/functional.h"
+#include <climits>
+#include <functional>
 #include <stop_token>
 
 namespace dawn {
@@ -14,6 +16,104 @@ enum class Polarity
 	random
 };
 
+// exponential moving average with bias correction, i.e., the first few
+// updates are not dragged towards the zero initial value
+class Ema
+{
+	double alpha_;
+	double biased_ = 0, beta_ = 1, value_ = 0;
+
+  public:
+	explicit Ema(double alpha) : alpha_(alpha) {}
+
+	void update(double x)
+	{
+		biased_ += alpha_ * (x - biased_);
+		beta_ *= 1 - alpha_;
+		value_ = biased_ / (1 - beta_);
+	}
+
+	double operator()() const { return value_; }
+};
+
+// Schedule for alternating between two search modes:
+//   * 'focused': dynamic restarts and VMTF (or fast activity decay), which is
+//     usually good for finding refutations
+//   * 'stable': rare (Luby) restarts and slow activity decay, which is usually
+//     good for finding solutions
+// Starts in focused mode, phase lengths (in conflicts) grow geometrically. This
+// lives outside of the Searcher, which is only used for a single epoch.
+struct ModeSchedule
+{
+	bool stable = false;
+	int64_t length = 1000;    // length of the current phase
+	int64_t remaining = 1000; // conflicts until the next switch
+	double mult = 2.0;        // growth of phase lengths
+
+	void next()
+	{
+		stable = !stable;
+		length = (int64_t)(length * mult);
+		remaining = length;
+	}
+};
+
+// rephasing, i.e., overwriting all saved phases
+enum class Rephase
+{
+	original, // starting polarity
+	inverted, // opposite of starting polarity
+	best,     // assignment of the largest conflict-free trail so far
+	random,
+	walk // local search, starting at the saved phases (see 'Sls')
+};
+
+// Phases that are kept across searchers (i.e. epochs), together with the
+// schedule for rephasing:
+//   * 'saved': last assignment of each variable (i.e. polarity saving)
+//   * 'target': assignment of the largest conflict-free trail since the last
+//     rephase. Decisions follow it outside of focused mode.
+//   * 'best': same as target, but only reset after being used by a rephase
+//   * stored in terms of outer variables, so that they survive renumbering
+//     done by inprocessing
+//   * rephase intervals (in conflicts) grow linearly
+//   * 'walk' works on the Cnf instead of the Searcher, so it is done by the
+//     caller between epochs. It is skipped unless 'walk' is set.
+struct PhaseState
+{
+	std::vector<lbool> saved, target, best; // indexed by outer variable
+	int64_t target_size = 0, best_size = 0; // number of assigned variables
+	int64_t interval = 1000;                // first rephase interval
+	int64_t remaining = 1000;               // conflicts until the next rephase
+	int64_t count = 0;                      // rephases so far
+	bool walk = false;                      // do local search rephases
+
+	static constexpr Rephase cycle[] = {
+	    Rephase::inverted, Rephase::best, Rephase::walk,
+	    Rephase::best,     Rephase::random, Rephase::best,
+	    Rephase::walk,     Rephase::best, Rephase::original,
+	    Rephase::best};
+
+	// upcoming rephase
+	Rephase peek() const
+	{
+		int64_t i = count;
+		while (!walk && cycle[i % std::size(cycle)] == Rephase::walk)
+			++i;
+		return cycle[i % std::size(cycle)];
+	}
+
+	Rephase next()
+	{
+		Rephase r;
+		do
+			r = cycle[count++ % std::size(cycle)];
+		while (!walk && r == Rephase::walk);
+		remaining = interval * (count + 1);
+		return r;
+	}
+};
+
 // Core of a CDCL solver. This wraps a PropEngine together with some auxiliary
 // state (variable activity, polarity).
 //   * 'Searcher' owns all its data (clauses, activity heap, ...), so multiple
@@ -34,11 +134,59 @@ class Searcher
 		// branching heuristic
 		int branch_dom = 0; // branch on dominator instead of chosen literal
 		                    // (0=off, 1=only matching polarity, 2=always)
+		Heuristic heuristic = Heuristic::vsids;
+		float decay = 1.05; // activity decay (see ActivityHeap::set_decay)
+		int target_phases = 1; // decide by target phase instead of saved one
+		                       // (0=off, 1=except in focused mode, 2=always)
 
 		// restarts
 		RestartType restart_type = RestartType::luby;
 		int restart_base = 100;
-		float restart_mult = 1.1; // only for geometric
+		float restart_mult = 1.1;    // only for geometric
+		float restart_margin = 1.25; // only for dynamic
+		float restart_block = 1.4;   // only for dynamic
+
+		// mode switching (optional, not owned). Overrides restart type and
+		// activity decay with the parameters of the current mode.
+		ModeSchedule *modes = nullptr;
+		Heuristic focused_heuristic = Heuristic::vmtf; // stable is vsids
+		float focused_decay = 1.25;
+		float stable_decay = 1.05;
+		int stable_restart_base = 1024; // luby restarts in stable mode
+
+		// phases (optional, not owned). Saved/target/best phases are taken
+		// from it and written back at the end of 'run_epoch'. Rephasing is
+		// only done if 'rephase' is set, and never 'walk' (see 'PhaseState').
+		PhaseState *phases = nullptr;
+		bool rephase = true;
+
+		// assumptions (not owned). Decided in order before any other branch,
+		// one per level. If one of them fails, the search stops and the
+		// responsible ones are returned in 'Result::failed'.
+		std::span<const Lit> assumptions;
+
+		// callbacks (optional). 'terminate' is polled along with the stop
+		// token, 'learn' gets each learnt clause with at most
+		// 'learn_max_size' literals and LBD (in inner variables).
+		std::function<bool()> terminate;
+		std::function<void(std::span<const Lit>)> learn;
+		int learn_max_size = 0;
+		int learn_max_lbd = INT_MAX;
+
+		// model enumeration (optional). Each solution is passed to 'on_model'
+		// instead of ending the search. It is then blocked by the negation of
+		// its decisions, which is the shortest clause that is sure to exclude
+		// it. Blocking clauses are returned in 'Result::learnts' (as
+		// irredundant). The search ends when no solution is left, or when
+		// 'on_model' returns false.
+		//   * with a (non-empty) projection, its variables are decided first
+		//     and only their decisions are blocked. Thus solutions differing
+		//     only outside of the projection are found at most once.
+		//   * with assumptions, blocking clauses contain their negation, i.e.,
+		//     only hold under the same assumptions
+		//   * not compatible with proof logging
+		std::function<bool(Assignment const &)> on_model;
+		std::span<const int> projection;
 
 		// mic
 		int green_cutoff = 8; // max size of clause to be considered good
@@ -48,27 +196,88 @@ class Searcher
 	{
 		ClauseStorage learnts;
 		std::optional<Assignment> solution;
+		std::optional<std::vector<Lit>> failed; // failed assumptions
 		PropStats stats;
 	};
 
   private:
-	// number of restarts so far
+	// number of restarts so far (in the current mode)
 	int64_t iter_ = 0;
+	bool stable_ = false; // current mode (only with 'config.modes')
+
+	// dynamic restarts (Glucose-style): restart when recent learnt clauses
+	// have a higher LBD than the average. Block restarts when the trail is
+	// unusually long, as the solver might be close to a solution.
+	Ema lbd_fast_{0.03}, lbd_slow_{1e-5}, trail_size_{1. / 5000};
+	int64_t nConfls_ = 0; // total conflicts of this searcher
 
 	// temporary buffer for learnt clauses
 	std::vector<Lit> buf_;
 
 	PropEngine p_;
 	ActivityHeap act_;
-	util::bit_vector polarity_;
+	VmtfQueue vmtf_;
+	LrbQueue lrb_;
+	Heuristic heuristic_ = Heuristic::vsids; // decision queue currently in use
+	util::bit_vector polarity_; // saved phases
+	util::bit_vector target_, best_;
+	int64_t target_size_ = 0, best_size_ = 0;
+
+	// model enumeration (see 'config.on_model'). Projection variables before
+	// 'proj_next_' are known to be assigned.
+	util::bit_vector in_projection_;
+	size_t proj_next_ = 0;
+	bool enum_done_ = false; // no solutions left, or stopped by callback
+
+	// proof logging (see 'Cnf::proof'). The inner->outer mapping of variables
+	// is fixed for the lifetime of the searcher, so it is copied upfront.
+	// (also used for exchanging phases with 'config.phases')
+	ProofWriter *proof_ = nullptr;
+	std::vector<Lit> outer_, proof_buf_, chain_, proof_chain_;
+	std::vector<CRef> red_learnts_; // to be deleted from the proof eventually
+	void write_proof(char kind, std::span<const Lit> cl,
+	                 std::span<const Lit> chain = {});
+
+	// unroll, re-adding variables to the decision queue in use
+	void unroll(int level);
 
 	// Choose unassigned variable (and polarity) to branch on.
 	// Returns Lit::undef() if everything is assigned.
 	Lit choose_branch();
 
+	// pass the current solution to 'config.on_model', and add a clause that
+	// blocks it. Returns false if the search should stop.
+	bool block_solution(Result &result);
+
+	// take over mode from 'config.modes', adjusting heuristic and decay
+	void set_mode();
+
+	// starting polarity (or the opposite of it) for all variables
+	void set_original_polarity(bool inverted);
+
+	// exchange saved/target/best phases with 'config.phases'
+	void load_phases();
+	void store_phases();
+
+	// remember the conflict-free part of the trail if it is the largest so
+	// far (called on every conflict)
+	void update_target();
+
+	// overwrite saved (and target) phases
+	void rephase(Rephase r);
+
+	// stop token or 'config.terminate'
+	bool interrupted(std::stop_token const &stoken) const;
+
+	// restart policy of the current mode
+	RestartType restart_type() const;
+	int restart_base() const;
+
 	// run one 'restart', i.e. starting and ending at decision level 0
 	//   * number of conflicts in this restart is determined by config
-	void run_restart(Result &result, std::stop_token stoken);
+	//   * dynamic restarts are only limited by 'max_confls'
+	void run_restart(Result &result, int64_t max_confls,
+	                 std::stop_token stoken);
 
 	Config config_;
 
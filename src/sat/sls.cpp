@@ -0,0 +1,206 @@
+#include "sat/sls.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace dawn {
+
+namespace {
+// parameters of ProbSAT for 3-SAT with polynomial break function
+constexpr double cb = 2.06, eps = 0.9;
+constexpr int max_break = 64; // larger break values share a probability
+} // namespace
+
+Sls::Sls(Cnf const &cnf) : value_(cnf.var_count())
+{
+	int n = cnf.var_count();
+
+	clause_start_.push_back(0);
+	auto add = [&](std::span<const Lit> cl) {
+		lits_.insert(lits_.end(), cl.begin(), cl.end());
+		clause_start_.push_back((uint32_t)lits_.size());
+	};
+	for (Lit a : cnf.units)
+		add(std::array{a});
+	for (Lit a : cnf.all_lits())
+		for (Lit b : cnf.bins[a])
+			if (a < b)
+				add(std::array{a, b});
+	for (auto const &cl : cnf.clauses.all())
+		if (cl.color() == Color::blue)
+			add(cl.lits());
+
+	// occurrence lists (counting sort by literal)
+	occ_start_.assign(2 * n + 1, 0);
+	for (Lit a : lits_)
+		occ_start_[a + 1] += 1;
+	for (int i = 0; i < 2 * n; ++i)
+		occ_start_[i + 1] += occ_start_[i];
+	occs_.resize(lits_.size());
+	auto pos = occ_start_;
+	for (int c = 0; c < (int)clause_count(); ++c)
+		for (Lit a : clause(c))
+			occs_[pos[a]++] = c;
+
+	num_true_.resize(clause_count());
+	crit_.resize(clause_count());
+	unsat_pos_.resize(clause_count());
+	break_.resize(n);
+	for (int b = 0; b <= max_break; ++b)
+		prob_.push_back(std::pow(eps + b, -cb));
+}
+
+std::span<const Lit> Sls::clause(int c) const
+{
+	return std::span(lits_).subspan(clause_start_[c],
+	                                clause_start_[c + 1] - clause_start_[c]);
+}
+
+void Sls::add_unsat(int c)
+{
+	assert(unsat_pos_[c] == -1);
+	unsat_pos_[c] = (int)unsat_.size();
+	unsat_.push_back(c);
+}
+
+void Sls::remove_unsat(int c)
+{
+	int i = unsat_pos_[c];
+	assert(i != -1);
+	unsat_[i] = unsat_.back();
+	unsat_pos_[unsat_[i]] = i;
+	unsat_.pop_back();
+	unsat_pos_[c] = -1;
+}
+
+void Sls::flip(int v)
+{
+	Lit t = Lit(v, value_[v]); // false before the flip, true afterwards
+	value_[v] ^= 1;
+	flips += 1;
+
+	for (uint32_t i = occ_start_[t]; i < occ_start_[t + 1]; ++i)
+	{
+		int c = occs_[i];
+		if (num_true_[c] == 0)
+		{
+			remove_unsat(c);
+			break_[v] += 1;
+		}
+		else if (num_true_[c] == 1)
+			break_[crit_[c]] -= 1;
+		num_true_[c] += 1;
+		crit_[c] ^= v;
+	}
+
+	Lit f = t.neg();
+	for (uint32_t i = occ_start_[f]; i < occ_start_[f + 1]; ++i)
+	{
+		int c = occs_[i];
+		num_true_[c] -= 1;
+		crit_[c] ^= v;
+		if (num_true_[c] == 0)
+		{
+			add_unsat(c);
+			break_[v] -= 1;
+		}
+		else if (num_true_[c] == 1)
+			break_[crit_[c]] += 1;
+	}
+}
+
+void Sls::update_best()
+{
+	// 'since_best_' holds all flips since 'best_' was last updated. If there
+	// were too many of them, copying the whole assignment is cheaper.
+	if (since_best_overflow_)
+		best_ = value_;
+	else
+		for (int v : since_best_)
+			best_[v] ^= 1;
+	since_best_.clear();
+	since_best_overflow_ = false;
+	best_unsat_ = unsat_.size();
+}
+
+bool Sls::run(Assignment const &start, int64_t max_flips,
+              util::xoshiro256 &rng, std::stop_token stoken)
+{
+	// initial assignment
+	for (int v = 0; v < var_count(); ++v)
+	{
+		lbool x = v < start.var_count() ? start(v) : lundef;
+		value_[v] = x == lundef ? rng() & 1 : x == ltrue;
+	}
+
+	// initialize caches
+	std::fill(num_true_.begin(), num_true_.end(), 0);
+	std::fill(crit_.begin(), crit_.end(), 0);
+	std::fill(break_.begin(), break_.end(), 0);
+	std::fill(unsat_pos_.begin(), unsat_pos_.end(), -1);
+	unsat_.clear();
+	for (int c = 0; c < (int)clause_count(); ++c)
+	{
+		for (Lit a : clause(c))
+			if (value_[a.var()] != a.sign())
+			{
+				num_true_[c] += 1;
+				crit_[c] ^= a.var();
+			}
+		if (num_true_[c] == 0)
+			add_unsat(c);
+		else if (num_true_[c] == 1)
+			break_[crit_[c]] += 1;
+	}
+
+	best_ = value_;
+	since_best_.clear();
+	since_best_overflow_ = false;
+	best_unsat_ = unsat_.size();
+
+	for (int64_t i = 0; i < max_flips && !unsat_.empty(); ++i)
+	{
+		if (i % 4096 == 0 && stoken.stop_requested())
+			break;
+
+		// pick a random unsatisfied clause
+		auto cl = clause(unsat_[rng() % unsat_.size()]);
+
+		// pick a variable, biased towards small break values
+		weights_.clear();
+		double sum = 0;
+		for (Lit a : cl)
+		{
+			sum += prob_[std::min(break_[a.var()], max_break)];
+			weights_.push_back(sum);
+		}
+		double r = rng.uniform() * sum;
+		size_t k = 0;
+		while (k + 1 < cl.size() && weights_[k] <= r)
+			++k;
+		int v = cl[k].var();
+
+		flip(v);
+		if (!since_best_overflow_)
+		{
+			since_best_.push_back(v);
+			if (since_best_.size() > value_.size())
+				since_best_overflow_ = true;
+		}
+		if (unsat_.size() < best_unsat_)
+			update_best();
+	}
+
+	return unsat_.empty();
+}
+
+Assignment Sls::best() const
+{
+	auto a = Assignment(var_count());
+	for (int v = 0; v < var_count(); ++v)
+		a.set(Lit(v, !best_[v]));
+	return a;
+}
+
+} // namespace dawn
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "sat/assignment.h"
+#include "sat/cnf.h"
+#include "util/random.h"
+#include <cstdint>
+#include <stop_token>
+#include <vector>
+
+namespace dawn {
+
+// Stochastic local search in the style of ProbSAT (Balint and Schöning 2012):
+// Repeatedly pick a random unsatisfied clause and flip one of its variables,
+// chosen with probability decreasing polynomially in its break value.
+//   * works on a flat copy of the irredundant part of a Cnf (units, binaries
+//     from the BinaryGraph, long clauses from the ClauseStorage). Learnt
+//     clauses are implied, so they are ignored.
+//   * break values are cached, i.e., each clause knows its number of true
+//     literals and (via XOR of their variables) the 'critical' one if there
+//     is only one. A flip only touches the occurrence lists of the variable.
+//   * unsatisfied clauses are kept in a list with O(1) insert/remove
+//   * the assignment with the fewest unsatisfied clauses is tracked lazily,
+//     by remembering the flips since it was last updated
+class Sls
+{
+	// clauses in CSR format
+	std::vector<Lit> lits_;
+	std::vector<uint32_t> clause_start_;
+	std::vector<int> occs_; // clause indices, grouped by literal
+	std::vector<uint32_t> occ_start_;
+
+	// state of the search
+	std::vector<uint8_t> value_;      // current value of each variable
+	std::vector<int> num_true_;       // true literals per clause
+	std::vector<int> crit_;           // XOR of the true variables per clause
+	std::vector<int> break_;          // per variable
+	std::vector<int> unsat_;          // unsatisfied clauses
+	std::vector<int> unsat_pos_;      // position in 'unsat_' (or -1)
+	std::vector<double> prob_;        // by break value
+	std::vector<double> weights_;     // temporary while picking
+
+	// best assignment so far, plus flips since it was updated
+	std::vector<uint8_t> best_;
+	std::vector<int> since_best_;
+	bool since_best_overflow_ = false;
+	size_t best_unsat_ = SIZE_MAX;
+
+	void add_unsat(int c);
+	void remove_unsat(int c);
+	void flip(int v);
+	void update_best();
+	std::span<const Lit> clause(int c) const;
+
+  public:
+	// copies the irredundant clauses of 'cnf'
+	explicit Sls(Cnf const &cnf);
+
+	int var_count() const { return (int)value_.size(); }
+	size_t clause_count() const { return clause_start_.size() - 1; }
+
+	// Start at the given assignment (variables not assigned in 'start' are
+	// initialized randomly) and flip until all clauses are satisfied, or
+	// 'max_flips' is reached. Returns true if a solution was found.
+	bool run(Assignment const &start, int64_t max_flips, util::xoshiro256 &rng,
+	         std::stop_token stoken = {});
+
+	// number of unsatisfied clauses in the best assignment of the last 'run'
+	size_t best_unsat() const { return best_unsat_; }
+
+	// (complete) assignment with the fewest unsatisfied clauses so far
+	Assignment best() const;
+
+	// statistics
+	int64_t flips = 0;
+};
+
+} // namespace dawn
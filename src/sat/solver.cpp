@@ -3,14 +3,20 @@
 #include "fmt/format.h"
 #include "sat/disjunction.h"
 #include "sat/elimination.h"
+#include "sat/parallel.h"
 #include "sat/probing.h"
 #include "sat/propengine.h"
 #include "sat/redshift.h"
 #include "sat/searcher.h"
+#include "sat/sls.h"
 #include "sat/subsumption.h"
 #include "sat/vivification.h"
 #include "util/gnuplot.h"
+#include <algorithm>
+#include <cmath>
 #include <optional>
+#include <stdexcept>
+#include <utility>
 
 namespace dawn {
 
@@ -18,28 +24,30 @@ namespace dawn {
 void inprocess(Cnf &sat, SolverConfig const &config, std::stop_token stoken)
 {
 	// printBinaryStats(sat);
-	cleanup(sat);
+	cleanup(sat, config.threads);
 
 	if (config.subsume >= 1)
 	{
-		run_subsumption(sat);
-		cleanup(sat);
+		run_subsumption(sat, {.threads = config.threads});
+		cleanup(sat, config.threads);
 	}
 
 	if (config.bin_probing)
 	{
-		probe_binary(sat);
-		cleanup(sat);
+		probe_binary(sat, config.threads);
+		cleanup(sat, config.threads);
 	}
 
 	VivifyConfig vivConfig;
+	vivConfig.threads = config.threads;
 	if (config.vivify < 2)
 		vivConfig.with_binary = false;
 
 	if (config.vivify >= 1)
 	{
 		run_vivification(sat, vivConfig, stoken);
-		cleanup(sat); // bin-vivify really likes SCC and TBR before
+		// bin-vivify really likes SCC and TBR before
+		cleanup(sat, config.threads);
 	}
 
 	if (config.bva >= 1)
@@ -47,23 +55,61 @@ void inprocess(Cnf &sat, SolverConfig const &config, std::stop_token stoken)
 		makeDisjunctions(sat);
 		if (config.vivify >= 1)
 			run_vivification(sat, vivConfig, stoken);
-		cleanup(sat);
+		cleanup(sat, config.threads);
 	}
 }
 
-void preprocess(Cnf &sat)
+// local search rephase: start at the saved phases and replace them (and the
+// target phases) by the best assignment found. Returns true if that is a
+// solution, which is then written to 'sol' (in inner variables).
+bool walk(Cnf const &sat, PhaseState &phases, SolverConfig const &config,
+          Assignment &sol, std::stop_token stoken)
+{
+	auto log = util::Logger("walk");
+	auto const &recon = sat.reconstruction();
+
+	auto start = Assignment(sat.var_count());
+	for (int i = 0; i < sat.var_count(); ++i)
+	{
+		Lit a = recon.outer(Lit(i, false));
+		if (a.var() < (int)phases.saved.size() &&
+		    phases.saved[a.var()] != lundef)
+			start.set(Lit(i, (phases.saved[a.var()] ^ a.sign()) == lfalse));
+	}
+
+	auto sls = Sls(sat);
+	auto rng = util::xoshiro256(config.seed + phases.count);
+	int64_t max_flips = config.walk_effort * (int64_t)sls.clause_count();
+	bool found = sls.run(start, max_flips, rng, stoken);
+	log.info("{} of {} clauses unsatisfied after {} flips", sls.best_unsat(),
+	         sls.clause_count(), sls.flips);
+
+	sol = sls.best();
+	for (int i = 0; i < sat.var_count(); ++i)
+	{
+		Lit a = recon.outer(Lit(i, false));
+		if (a.var() >= (int)phases.saved.size())
+			phases.saved.resize(a.var() + 1, lundef);
+		phases.saved[a.var()] = lbool(sol.satisfied(Lit(i, false))) ^ a.sign();
+	}
+	phases.target = phases.saved;
+	phases.target_size = 0;
+	return found;
+}
+
+void preprocess(Cnf &sat, SolverConfig const &config)
 {
 	// elimination and subsumption influence each other quite a bit. SatELite
 	// alternatates them until fixed point. Cryptominisat seems to do multiple
 	// passes with increasing max-growth. For now, we just copy that strategy...
 
-	cleanup(sat);
-	run_subsumption(sat);
-	cleanup(sat);
-	run_vivification(sat, {}, {});
-	cleanup(sat);
-	run_subsumption(sat);
-	cleanup(sat);
+	cleanup(sat, config.threads);
+	run_subsumption(sat, {.threads = config.threads});
+	cleanup(sat, config.threads);
+	run_vivification(sat, {.threads = config.threads}, {});
+	cleanup(sat, config.threads);
+	run_subsumption(sat, {.threads = config.threads});
+	cleanup(sat, config.threads);
 	print_stats(sat);
 
 	for (int g = 0; g <= 16;)
@@ -73,14 +119,16 @@ void preprocess(Cnf &sat)
 		// vivification), but they are actually useful: eventual problem size
 		// will be smaller with more resolvents.
 		run_redshift(sat, {});
-		bool change = run_elimination(sat, {.growth = g, .green_cutoff = 4});
-		cleanup(sat);
-		run_subsumption(sat);
-		cleanup(sat);
-		run_vivification(sat, {.only_new = true}, {});
-		cleanup(sat);
-		run_subsumption(sat);
-		cleanup(sat);
+		bool change = run_elimination(
+		    sat, {.growth = g, .green_cutoff = 4, .threads = config.threads});
+		cleanup(sat, config.threads);
+		run_subsumption(sat, {.threads = config.threads});
+		cleanup(sat, config.threads);
+		run_vivification(sat, {.only_new = true, .threads = config.threads},
+		                 {});
+		cleanup(sat, config.threads);
+		run_subsumption(sat, {.threads = config.threads});
+		cleanup(sat, config.threads);
 		if (!change)
 		{
 			g += 8;
@@ -88,36 +136,54 @@ void preprocess(Cnf &sat)
 		}
 	}
 
-	if (sat.var_count() < 3000)
+	// binary probing is quadratic, so more threads allow for a bit larger
+	// problems in the same time
+	if (sat.var_count() < 3000 * std::sqrt(effective_threads(config.threads)))
 	{
-		probe_binary(sat);
-		cleanup(sat);
-		run_vivification(sat, {}, {});
-		cleanup(sat);
-		run_subsumption(sat);
-		cleanup(sat);
+		probe_binary(sat, config.threads);
+		cleanup(sat, config.threads);
+		run_vivification(sat, {.threads = config.threads}, {});
+		cleanup(sat, config.threads);
+		run_subsumption(sat, {.threads = config.threads});
+		cleanup(sat, config.threads);
 	}
 
 	print_stats(sat);
 }
 
 int solve(Cnf &sat, Assignment &sol, SolverConfig const &config,
-          std::stop_token stoken)
+          std::stop_token stoken, std::span<const Lit> assumptions,
+          std::vector<Lit> *failed, SolverCallbacks const &callbacks)
 {
 	auto log = util::Logger("solver");
 	std::optional<util::Gnuplot> plt;
 	if (config.plot)
 		plt.emplace();
+	if (failed)
+		failed->clear();
 
 	cleanup(sat);
 	log.info("starting solver with {} vars and {} clauses", sat.var_count(),
 	         sat.clause_count());
-	preprocess(sat);
+	if (config.preprocess)
+		preprocess(sat, config);
 
 	log.info("after preprocessing, got {} vars and {} clauses", sat.var_count(),
 	         sat.clause_count());
 
 	PropStats propStats = {};
+	ModeSchedule modes = {.length = config.mode_length,
+	                      .remaining = config.mode_length,
+	                      .mult = config.mode_mult};
+	PhaseState phases;
+	phases.interval = phases.remaining = config.rephase_interval;
+	// local search knows nothing about assumptions, enumeration or XORs
+	phases.walk = config.walk_effort > 0 && assumptions.empty() &&
+	              !callbacks.on_model && sat.xors.empty();
+	std::vector<Lit> inner_assumptions;
+	std::vector<int> inner_projection;
+	std::vector<Lit> to_external, learn_buf;
+	bool terminated = false;
 
 	// main solver loop
 	for (int epoch = 0;; ++epoch)
@@ -129,12 +195,114 @@ int solve(Cnf &sat, Assignment &sol, SolverConfig const &config,
 			return 30;
 		}
 
+		if (sat.contradiction)
+			return 20;
+
+		// assumptions in current inner variables. Fixed ones are either
+		// skipped or fail right away.
+		inner_assumptions.clear();
+		for (Lit a : assumptions)
+		{
+			Lit b = sat.external[a.var()];
+			assert(b != Lit::elim());
+			b = b ^ a.sign();
+			if (b == Lit::zero())
+			{
+				if (failed)
+					failed->assign({a});
+				return 20;
+			}
+			if (b != Lit::one())
+				inner_assumptions.push_back(b);
+		}
+
+		// projection in current inner variables. Fixed ones do not matter,
+		// and if all variables are left, there is nothing to project.
+		inner_projection.clear();
+		if (callbacks.on_model)
+		{
+			util::bit_vector seen(sat.var_count());
+			for (int v : callbacks.projection)
+			{
+				Lit b = sat.external[v];
+				assert(b != Lit::elim());
+				if (!b.fixed() && !seen[b.var()])
+				{
+					seen[b.var()] = true;
+					inner_projection.push_back(b.var());
+				}
+			}
+			if (callbacks.projection.empty() ||
+			    (int)inner_projection.size() == sat.var_count())
+				inner_projection.clear();
+		}
+
+		// local search is done between epochs, as it works on the Cnf
+		if (config.rephase && phases.remaining <= 0 &&
+		    phases.peek() == Rephase::walk)
+		{
+			phases.next();
+			Assignment walk_sol;
+			if (walk(sat, phases, config, walk_sol, stoken))
+			{
+				sol = sat.reconstruct_solution(walk_sol);
+				return 10;
+			}
+		}
+
 		Searcher::Config sconfig;
 		sconfig.otf = config.otf;
 		sconfig.branch_dom = config.branch_dom;
 		sconfig.restart_type = config.restart_type;
 		sconfig.restart_base = config.restart_base;
 		sconfig.restart_mult = config.restart_mult;
+		sconfig.restart_margin = config.restart_margin;
+		sconfig.restart_block = config.restart_block;
+		sconfig.heuristic = config.heuristic;
+		sconfig.decay = config.decay;
+		if (config.modes)
+			sconfig.modes = &modes;
+		sconfig.focused_heuristic = config.focused_heuristic;
+		sconfig.focused_decay = config.focused_decay;
+		sconfig.stable_decay = config.stable_decay;
+		sconfig.stable_restart_base = config.stable_restart_base;
+		sconfig.target_phases = config.target_phases;
+		sconfig.phases = &phases;
+		sconfig.rephase = config.rephase;
+		sconfig.assumptions = inner_assumptions;
+		if (callbacks.terminate)
+			sconfig.terminate = [&] {
+				return terminated = terminated || callbacks.terminate();
+			};
+		if (callbacks.learn)
+		{
+			// inner -> external, for variables that have one
+			to_external.assign(sat.var_count(), Lit::undef());
+			for (int i = 0; i < (int)sat.external.size(); ++i)
+				if (Lit a = sat.external[i]; a.proper())
+					to_external[a.var()] = Lit(i, a.sign());
+			sconfig.learn = [&](std::span<const Lit> cl) {
+				learn_buf.clear();
+				for (Lit a : cl)
+				{
+					if (to_external[a.var()] == Lit::undef())
+						return;
+					learn_buf.push_back(to_external[a.var()] ^ a.sign());
+				}
+				callbacks.learn(learn_buf);
+			};
+			sconfig.learn_max_size = callbacks.learn_max_size;
+			sconfig.learn_max_lbd = callbacks.learn_max_lbd;
+		}
+		if (callbacks.on_model)
+		{
+			sconfig.on_model = [&](Assignment const &a) {
+				if (!callbacks.on_model(sat.reconstruct_solution(a)))
+					terminated = true;
+				return !terminated;
+			};
+			sconfig.projection = inner_projection;
+		}
 		util::Stopwatch sw;
 		sw.start();
 		auto result = Searcher(sat, sconfig).run_epoch(10'000, stoken);
@@ -147,8 +315,13 @@ int solve(Cnf &sat, Assignment &sol, SolverConfig const &config,
 		         result.stats.nProps() / sw.secs() / 1000);
 
 		propStats += result.stats;
-		for (auto const &cl : result.learnts.all())
-			sat.add_clause(cl, cl.color());
+		{
+			// already written to the proof by the searcher
+			auto proof = std::exchange(sat.proof, nullptr);
+			for (auto const &cl : result.learnts.all())
+				sat.add_clause(cl, cl.color());
+			sat.proof = proof;
+		}
 
 		if (result.solution)
 		{
@@ -160,7 +333,22 @@ int solve(Cnf &sat, Assignment &sol, SolverConfig const &config,
 		if (sat.contradiction)
 			return 20;
 
-		if (stoken.stop_requested())
+		if (result.failed)
+		{
+			// map back to the assumptions as given
+			if (failed)
+			{
+				failed->clear();
+				for (Lit a : assumptions)
+					if (std::ranges::find(*result.failed,
+					                      sat.external[a.var()] ^ a.sign()) !=
+					    result.failed->end())
+						failed->push_back(a);
+			}
+			return 20;
+		}
+
+		if (stoken.stop_requested() || terminated)
 		{
 			log.info("interrupted. abort solver.");
 			return 30;
@@ -192,4 +380,35 @@ int solve(Cnf &sat, Assignment &sol, SolverConfig const &config,
 	}
 }
 
+int solve_sls(Cnf &sat, Assignment &sol, SolverConfig const &config,
+              std::stop_token stoken)
+{
+	auto log = util::Logger("sls");
+
+	cleanup(sat);
+	if (sat.contradiction)
+		return 20;
+
+	// local search only sees the clauses
+	if (!sat.xors.empty())
+		throw std::runtime_error("local search does not support XORs");
+
+	auto sls = Sls(sat);
+	auto rng = util::xoshiro256(config.seed);
+	log.info("starting local search with {} vars and {} clauses",
+	         sls.var_count(), sls.clause_count());
+	util::Stopwatch sw;
+	sw.start();
+	bool found = sls.run(Assignment(sat.var_count()), config.max_flips, rng,
+	                     stoken);
+	sw.stop();
+	log.info("{} flips ({:.2f} Mflips/s), best has {} unsatisfied clauses",
+	         sls.flips, sls.flips / sw.secs() / 1e6, sls.best_unsat());
+
+	if (!found)
+		return 30;
+	sol = sat.reconstruct_solution(sls.best());
+	return 10;
+}
+
 } // namespace dawn
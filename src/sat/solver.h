@@ -3,17 +3,64 @@
 #include "sat/assignment.h"
 #include "sat/propengine.h"
 #include <cassert>
+#include <climits>
+#include <functional>
+#include <span>
 #include <stop_token>
 #include <vector>
 
 namespace dawn {
 
+/**
+ * The preprocessing part of 'solve()', i.e. elimination, subsumption,
+ * vivification and such, but no search. Mostly useful to cache the result.
+ */
+void preprocess(Cnf &sat, SolverConfig const &config);
+
+/**
+ * Optional callbacks for 'solve()'
+ *   - 'terminate' is polled regularly during search, true stops the solver
+ *   - 'learn' gets learnt clauses with at most 'learn_max_size' literals and
+ *     LBD at most 'learn_max_lbd', in external variables (see
+ *     'Cnf::external'). Clauses containing variables without external
+ *     counterpart are skipped. This runs on the search thread, so it should
+ *     be fast (see 'ClauseExport' for an asynchronous alternative).
+ *   - 'on_model' turns 'solve()' into model enumeration (see
+ *     'Searcher::Config::on_model'). It gets each solution (in outer
+ *     variables), returning false stops the enumeration. Blocking clauses
+ *     stay in the formula. 'projection' is given in external variables,
+ *     which have to be frozen (empty means all variables).
+ */
+struct SolverCallbacks
+{
+	std::function<bool()> terminate;
+	std::function<void(std::span<const Lit>)> learn;
+	int learn_max_size = 0;
+	int learn_max_lbd = INT_MAX;
+	std::function<bool(Assignment const &)> on_model;
+	std::span<const int> projection;
+};
+
 /**
  * Solves a SAT problem.
  *   - configured using settings in 'sat.stats' (might be moved at some point)
  *   - returns 10=SAT, 20=UNSAT, 30=UNKNWON (timeout or some other limit)
+ *   - optionally under assumptions, given in external variables (see
+ *     'Cnf::external'), which have to be frozen. If they are the reason for
+ *     UNSAT, the responsible ones are written to 'failed'.
+ *   - with 'callbacks.on_model', returns 20 once all solutions are found,
+ *     and 30 if stopped before that (never 10)
  */
 int solve(Cnf &sat, Assignment &sol, SolverConfig const &config,
-          std::stop_token stoken);
+          std::stop_token stoken, std::span<const Lit> assumptions = {},
+          std::vector<Lit> *failed = nullptr,
+          SolverCallbacks const &callbacks = {});
+
+/**
+ * Stochastic local search only (see 'Sls'). Incomplete, i.e., never returns
+ * 20=UNSAT unless the formula is trivially unsatisfiable.
+ */
+int solve_sls(Cnf &sat, Assignment &sol, SolverConfig const &config,
+              std::stop_token stoken);
 
 } // namespace dawn
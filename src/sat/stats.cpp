@@ -45,6 +45,11 @@ void PropStats::dump(bool with_histograms)
 	           100. * nLongProps / watchHistogram.sum());
 	fmt::print("c long confls:    {:#10} ({:#4.1f} % of watches)\n",
 	           nLongConfls, 100. * nLongConfls / watchHistogram.sum());
+	if (nXorProps || nXorConfls)
+	{
+		fmt::print("c xor props:      {:#10}\n", nXorProps);
+		fmt::print("c xor confls:     {:#10}\n", nXorConfls);
+	}
 }
 
 PropStats &operator+=(PropStats &a, const PropStats &b)
@@ -59,6 +64,8 @@ PropStats &operator+=(PropStats &a, const PropStats &b)
 	a.nLongShifts += b.nLongShifts;
 	a.nLongProps += b.nLongProps;
 	a.nLongConfls += b.nLongConfls;
+	a.nXorProps += b.nXorProps;
+	a.nXorConfls += b.nXorConfls;
 	a.nLitsLearnt += b.nLitsLearnt;
 	a.nLitsOtfRemoved += b.nLitsOtfRemoved;
 
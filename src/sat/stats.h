@@ -12,7 +12,16 @@ enum class RestartType
 	constant,
 	linear,
 	geometric,
-	luby
+	luby,
+	dynamic
+};
+
+// decision heuristic
+enum class Heuristic
+{
+	vsids, // variable activity (ActivityHeap)
+	vmtf,  // variable-move-to-front (VmtfQueue)
+	lrb    // learning-rate based (LrbQueue)
 };
 
 struct SolverConfig
@@ -22,6 +31,8 @@ struct SolverConfig
 	                    // (0=off, 1=basic, 2=recursive)
 	int branch_dom = 0; // branch on dominator instead of chosen one itself
 	                    // ( 0=off, 1=matching polarity only, 2=always
+	float decay = 1.05; // activity decay
+	Heuristic heuristic = Heuristic::vsids;
 
 	// clause cleaning
 	int max_learnt_size = 100;
@@ -30,7 +41,28 @@ struct SolverConfig
 	// restarts
 	RestartType restart_type = RestartType::luby;
 	int restart_base = 100;
-	float restart_mult = 1.1; // only for geometric
+	float restart_mult = 1.1;    // only for geometric
+	float restart_margin = 1.25; // only for dynamic
+	float restart_block = 1.4;   // only for dynamic
+
+	// alternate between focused and stable mode (see 'ModeSchedule')
+	bool modes = false;
+	int64_t mode_length = 1000; // conflicts of the first (focused) phase
+	float mode_mult = 2.0;
+	Heuristic focused_heuristic = Heuristic::vmtf; // stable is always vsids
+	float focused_decay = 1.25;
+	float stable_decay = 1.05;
+	int stable_restart_base = 1024;
+
+	// phases (see 'PhaseState')
+	int target_phases = 1; // 0=off, 1=except in focused mode, 2=always
+	int rephase = 1;
+	int64_t rephase_interval = 1000;
+	int walk_effort = 10; // flips per clause in local search rephases
+
+	// standalone local search (instead of CDCL)
+	bool sls = false;
+	int64_t max_flips = INT64_MAX;
 
 	// pre-/inprocessing
 	int subsume = 2;     // subsumption and self-subsuming resolution
@@ -41,7 +73,12 @@ struct SolverConfig
 	int bce = 1;         // blocked clause elimination
 	int bva = 0;         // bounded variable addition
 
+	// turned off for input which is already preprocessed (i.e. cached)
+	bool preprocess = true;
+
 	// other
+	int threads = 1; // threads for pre-/inprocessing (<= 0 means all cores)
+	uint64_t seed = 0; // for local search
 	int64_t max_confls = INT64_MAX; // stop solving
 	bool plot = false;
 };
@@ -63,10 +100,11 @@ struct PropStats
 	int64_t nBinSatisfied = 0, nBinProps = 0, nBinConfls = 0;
 	int64_t nLongSatisfied = 0, nLongShifts = 0, nLongProps = 0,
 	        nLongConfls = 0;
+	int64_t nXorProps = 0, nXorConfls = 0;
 	int64_t nLitsLearnt = 0, nLitsOtfRemoved = 0;
 
-	int64_t nProps() const { return nBinProps + nLongProps; }
-	int64_t nConfls() const { return nBinConfls + nLongConfls; }
+	int64_t nProps() const { return nBinProps + nLongProps + nXorProps; }
+	int64_t nConfls() const { return nBinConfls + nLongConfls + nXorConfls; }
 
 	// Write stats to stdout. Usually called once at the end of solving
 	void dump(bool with_histograms);
@@ -1,19 +1,25 @@
 #include "sat/subsumption.h"
 
 #include "fmt/format.h"
+#include "sat/parallel.h"
 #include "util/bit_vector.h"
 #include "util/logging.h"
 #include "util/span.h"
 
 namespace dawn {
 
-bool try_subsume(Clause &a, Clause &b)
-{
-	assert(a.color() != Color::black);
-	assert(b.color() != Color::black);
+namespace {
 
+// Check whether a subsumes b or can strengthen it (see 'try_subsume()').
+//    - returns Lit::undef() if a subsumes b
+//    - returns the literal that can be removed from b via self-subsuming
+//      resolution, if any
+//    - returns Lit::elim() otherwise
+// Does not modify anything, so it is safe to call concurrently.
+Lit check_subsume(Clause const &a, Clause const &b)
+{
 	if (a.size() > b.size())
-		return false;
+		return Lit::elim();
 
 	Lit x = Lit::undef();
 	for (int i = 0, j = 0; i < a.size(); ++i, ++j)
@@ -21,19 +27,55 @@ bool try_subsume(Clause &a, Clause &b)
 		while (j < b.size() && b[j].var() < a[i].var())
 			++j;
 		if (j == b.size())
-			return false;
+			return Lit::elim();
 
 		if (a[i] == b[j]) // exact match
 			continue;
 		else if (a[i] == b[j].neg()) // same variable, different sign
 		{
 			if (x != Lit::undef())
-				return false;
+				return Lit::elim();
 			x = b[j];
 		}
 		else
-			return false;
+			return Lit::elim();
+	}
+	return x;
+}
+
+// bookkeeping after 'try_subsume(a, b)' succeeded
+void handle_subsumed(Cnf &cnf, Clause &b, int64_t &nRemovedCls,
+                     int64_t &nRemovedLits)
+{
+	if (b.color() == Color::black)
+	{
+		nRemovedCls += 1;
+		return;
+	}
+
+	nRemovedLits += 1;
+	if (b.size() <= 2)
+	{
+		if (b.size() == 0)
+			cnf.add_empty(); // dont think this can happen
+		else if (b.size() == 1)
+			cnf.add_unary(b[0]);
+		else if (b.size() == 2)
+			cnf.add_binary(b[0], b[1]);
+		b.set_color(Color::black);
 	}
+}
+
+} // namespace
+
+bool try_subsume(Clause &a, Clause &b)
+{
+	assert(a.color() != Color::black);
+	assert(b.color() != Color::black);
+
+	Lit x = check_subsume(a, b);
+	if (x == Lit::elim())
+		return false;
 
 	if (x == Lit::undef())
 	{
@@ -45,6 +87,28 @@ bool try_subsume(Clause &a, Clause &b)
 	return true;
 }
 namespace {
+
+// mark all literals implied by a
+void mark_reachable(BinaryGraph const &bins, Lit a, util::bit_vector &seen,
+                    std::vector<Lit> &stack)
+{
+	seen.clear();
+	assert(stack.empty());
+	seen[a] = true;
+	stack.push_back(a);
+	while (!stack.empty())
+	{
+		Lit b = stack.back();
+		stack.pop_back();
+		for (Lit c : bins[b.neg()])
+			if (!seen[c])
+			{
+				seen[c] = true;
+				stack.push_back(c);
+			}
+	}
+}
+
 class Subsumption
 {
 	std::vector<Lit> stack; // temporary for DFS
@@ -55,7 +119,20 @@ class Subsumption
 	util::bit_vector seen;
 
 	// statistics
-	size_t nRemovedClsBin = 0, nRemovedLitsBin = 0;
+	int64_t nRemovedClsBin = 0, nRemovedLitsBin = 0;
+
+	// Subsumption/strengthening found by 'find_binary()', to be applied later
+	//   - cref = undef: 'a' is a failed literal
+	//   - remove = undef: clause is subsumed by the implication a -> witness
+	//   - otherwise: 'remove' (which is 'a') can be removed from the clause,
+	//     because it implies 'witness', which is also in the clause
+	struct BinaryHit
+	{
+		Lit a;
+		CRef cref;
+		Lit remove;
+		Lit witness;
+	};
 
 	Subsumption(Cnf &cnf)
 	    : cnf(cnf), occs(cnf.var_count() * 2), seen(cnf.var_count() * 2)
@@ -66,26 +143,6 @@ class Subsumption
 					occs[a].push_back(ci);
 	}
 
-	// mark all literals implied by a
-	void mark_reachable(Lit a)
-	{
-		seen.clear();
-		assert(stack.empty());
-		seen[a] = true;
-		stack.push_back(a);
-		while (!stack.empty())
-		{
-			Lit b = stack.back();
-			stack.pop_back();
-			for (Lit c : cnf.bins[b.neg()])
-				if (!seen[c])
-				{
-					seen[c] = true;
-					stack.push_back(c);
-				}
-		}
-	}
-
 	// perform subsumption and self-subsuming resolution using
 	// implications a -> X (also finds some failed literals)
 	void subsumeBinary(Lit a)
@@ -95,7 +152,7 @@ class Subsumption
 			return;
 
 		// mark all literals reachable from a
-		mark_reachable(a);
+		mark_reachable(cnf.bins, a, seen, stack);
 		seen[a] = false;
 
 		// if a implies ~a, we have a failed literal (should be rare here)
@@ -118,6 +175,7 @@ class Subsumption
 			for (Lit x : cnf.clauses[k].lits())
 				if (seen[x])
 				{
+					cnf.proof_delete(cl.lits());
 					cnf.clauses[k].set_color(Color::black);
 					++nRemovedClsBin;
 					break;
@@ -134,6 +192,7 @@ class Subsumption
 			for (Lit x : cl.lits())
 				if (seen[x])
 				{
+					cnf.proof_begin_change(cl);
 					if (cl.remove_literal(a))
 					{
 						++nRemovedLitsBin;
@@ -143,6 +202,7 @@ class Subsumption
 							cl.set_color(Color::black);
 						}
 					}
+					cnf.proof_end_change(cl);
 					break;
 				}
 		}
@@ -155,6 +215,103 @@ class Subsumption
 		for (Lit a : cnf.all_lits())
 			subsumeBinary(a);
 	}
+
+	// same as 'subsumeBinary(a)', but only records what it found instead of
+	// changing anything. Safe to run concurrently.
+	void find_binary(Lit a, util::bit_vector &seen_, std::vector<Lit> &stack_,
+	                 std::vector<BinaryHit> &hits) const
+	{
+		if (cnf.bins[a.neg()].empty())
+			return;
+
+		mark_reachable(cnf.bins, a, seen_, stack_);
+		seen_[a] = false;
+
+		if (seen_[a.neg()])
+		{
+			hits.push_back({a, CRef::undef(), Lit::undef(), Lit::undef()});
+			return;
+		}
+
+		for (CRef k : occs[a.neg()])
+			for (Lit x : cnf.clauses[k].lits())
+				if (seen_[x])
+				{
+					hits.push_back({a, k, Lit::undef(), x});
+					break;
+				}
+
+		for (CRef k : occs[a])
+			for (Lit x : cnf.clauses[k].lits())
+				if (seen_[x])
+				{
+					hits.push_back({a, k, a, x});
+					break;
+				}
+	}
+
+	// apply a hit found by 'find_binary()'. Other hits might have changed the
+	// clause in the meantime, so everything is re-checked.
+	void apply(BinaryHit const &hit)
+	{
+		if (hit.cref == CRef::undef())
+		{
+			cnf.add_unary(hit.a.neg());
+			return;
+		}
+
+		auto &cl = cnf.clauses[hit.cref];
+		if (cl.color() == Color::black || !cl.contains(hit.witness))
+			return;
+
+		if (hit.remove == Lit::undef())
+		{
+			if (!cl.contains(hit.a.neg()))
+				return;
+			cnf.proof_delete(cl.lits());
+			cl.set_color(Color::black);
+			++nRemovedClsBin;
+			return;
+		}
+
+		cnf.proof_begin_change(cl);
+		if (cl.remove_literal(hit.remove))
+		{
+			++nRemovedLitsBin;
+			if (cl.size() == 2)
+			{
+				cnf.add_binary(cl[0], cl[1]);
+				cl.set_color(Color::black);
+			}
+		}
+		cnf.proof_end_change(cl);
+	}
+
+	// parallel version of 'subsumeBinary()'. Each thread handles the literals
+	// of every 'threads'-th variable, results are merged in literal order.
+	void subsumeBinary(int threads)
+	{
+		std::vector<std::vector<BinaryHit>> hits(threads);
+		run_parallel(threads, [&](int t) {
+			auto seen_ = util::bit_vector(cnf.var_count() * 2);
+			std::vector<Lit> stack_;
+			for (int v = t; v < cnf.var_count(); v += threads)
+			{
+				find_binary(Lit(v, false), seen_, stack_, hits[t]);
+				find_binary(Lit(v, true), seen_, stack_, hits[t]);
+			}
+		});
+
+		std::vector<BinaryHit> all;
+		for (auto &h : hits)
+			all.insert(all.end(), h.begin(), h.end());
+		std::stable_sort(all.begin(), all.end(),
+		                 [](BinaryHit const &x, BinaryHit const &y) {
+			                 return (int)x.a < (int)y.a;
+		                 });
+		for (auto const &hit : all)
+			apply(hit);
+	}
 };
 
 std::pair<int64_t, int64_t> subsumeLong(Cnf &cnf)
@@ -207,25 +364,11 @@ std::pair<int64_t, int64_t> subsumeLong(Cnf &cnf)
 				Clause &cl2 = cnf.clauses[j];
 				if (cl2.color() == Color::black)
 					continue; // already removed by different subsumption
+				cnf.proof_begin_change(cl2);
 				if (try_subsume(cl, cl2))
-				{
-					if (cl2.color() == Color::black)
-						nRemovedClsLong += 1;
-					else
-					{
-						nRemovedLitsLong += 1;
-						if (cl2.size() <= 2)
-						{
-							if (cl2.size() == 0)
-								cnf.add_empty(); // dont think this can happen
-							else if (cl2.size() == 1)
-								cnf.add_unary(cl2[0]);
-							else if (cl2.size() == 2)
-								cnf.add_binary(cl2[0], cl2[1]);
-							cl2.set_color(Color::black);
-						}
-					}
-				}
+					handle_subsumed(cnf, cl2, nRemovedClsLong,
+					                nRemovedLitsLong);
+				cnf.proof_end_change(cl2);
 			}
 
 			// add vlause to occ-lists
@@ -237,17 +380,99 @@ std::pair<int64_t, int64_t> subsumeLong(Cnf &cnf)
 	return {nRemovedClsLong, nRemovedLitsLong};
 }
 
+// Parallel version of 'subsumeLong()'.
+//   * Each clause is used as subsumer only by the thread that owns the
+//     occurrence list of its pivot variable. Threads only collect candidate
+//     pairs, without modifying anything.
+//   * Candidates are then applied serially (from long to short subsumers, as
+//     in the serial version), re-checking each pair as earlier ones might have
+//     changed or removed the clauses involved.
+std::pair<int64_t, int64_t> subsumeLong(Cnf &cnf, int threads)
+{
+	auto occs = std::vector<util::small_vector<CRef, 7>>(cnf.var_count());
+	std::vector<CRef> crefs;
+	for (auto [ci, cl] : cnf.clauses.enumerate())
+		if (cl.color() != Color::black)
+		{
+			std::sort(cl.lits().begin(), cl.lits().end());
+			crefs.push_back(ci);
+			for (Lit a : cl.lits())
+				occs[a.var()].push_back(ci);
+		}
+
+	// choose variable with shortest occ-list as pivot for each clause
+	auto pivots = std::vector<int>(crefs.size());
+	for (size_t k = 0; k < crefs.size(); ++k)
+	{
+		Clause const &cl = cnf.clauses[crefs[k]];
+		int pivot = cl[0].var();
+		for (Lit lit : cl.lits())
+			if (occs[lit.var()].size() < occs[pivot].size())
+				pivot = lit.var();
+		pivots[k] = pivot;
+	}
+
+	using Candidate = std::pair<CRef, CRef>;
+	std::vector<std::vector<Candidate>> found(threads);
+	run_parallel(threads, [&](int t) {
+		for (size_t k = 0; k < crefs.size(); ++k)
+		{
+			if (pivots[k] % threads != t)
+				continue;
+			CRef i = crefs[k];
+			Clause const &cl = cnf.clauses[i];
+			for (CRef j : occs[pivots[k]])
+			{
+				if (i == j)
+					continue;
+				Clause const &cl2 = cnf.clauses[j];
+				if (cl2.size() < cl.size())
+					continue;
+				if (check_subsume(cl, cl2) != Lit::elim())
+					found[t].push_back({i, j});
+			}
+		}
+	});
+
+	std::vector<std::pair<int, Candidate>> all; // (-size of subsumer, pair)
+	for (auto &f : found)
+		for (auto c : f)
+			all.push_back({-(int)cnf.clauses[c.first].size(), c});
+	std::sort(all.begin(), all.end());
+
+	int64_t nRemovedClsLong = 0;
+	int64_t nRemovedLitsLong = 0;
+	for (auto [_, c] : all)
+	{
+		Clause &cl = cnf.clauses[c.first];
+		Clause &cl2 = cnf.clauses[c.second];
+		if (cl.color() == Color::black || cl2.color() == Color::black)
+			continue;
+		cnf.proof_begin_change(cl2);
+		if (try_subsume(cl, cl2))
+			handle_subsumed(cnf, cl2, nRemovedClsLong, nRemovedLitsLong);
+		cnf.proof_end_change(cl2);
+	}
+
+	return {nRemovedClsLong, nRemovedLitsLong};
+}
+
 } // namespace
 
-bool run_subsumption(Cnf &cnf)
+bool run_subsumption(Cnf &cnf, SubsumptionConfig const &config)
 {
 	// util::StopwatchGuard swg(cnf.stats.swSubsume);
 	auto log = util::Logger("subsumption");
+	int threads = effective_threads(config.threads, cnf.var_count());
 
 	Subsumption sub(cnf);
-	sub.subsumeBinary();
+	if (threads > 1)
+		sub.subsumeBinary(threads);
+	else
+		sub.subsumeBinary();
 
-	auto [nRemovedClsLong, nRemovedLitsLong] = subsumeLong(cnf);
+	auto [nRemovedClsLong, nRemovedLitsLong] =
+	    threads > 1 ? subsumeLong(cnf, threads) : subsumeLong(cnf);
 
 	log.info("removed {} + {} clauses and {} + {} lits", sub.nRemovedClsBin,
 	         nRemovedClsLong, sub.nRemovedLitsBin, nRemovedLitsLong);
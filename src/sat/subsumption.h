@@ -4,11 +4,20 @@
 
 namespace dawn {
 
+struct SubsumptionConfig
+{
+	// Number of threads (<= 0 means all cores). Candidates are searched
+	// concurrently, each thread owning the occurrence lists of a subset of
+	// variables. The actual removals/strengthenings are then applied serially
+	// in a deterministic order.
+	int threads = 1;
+};
+
 // perform subsumption and self-subsuming resolution
 //     - considers long/long and (virtual-)binary/long, but not binary/binary,
 //       which is taken care of by transitive binary reduction elsewhere
 //     - returns true if anything was found
-bool run_subsumption(Cnf &cnf);
+bool run_subsumption(Cnf &cnf, SubsumptionConfig const &config = {});
 
 // Try to subsume b using a. This can either:
 //    - do nothing (return false)
@@ -1,7 +1,9 @@
 #include "sat/vivification.h"
 
+#include "sat/parallel.h"
 #include "sat/propengine.h"
 #include "util/hash_map.h"
+#include <utility>
 
 // TODO: vivification needs some serious cleaning up.
 //    * maybe properly separate basic / binary / ternary
@@ -23,12 +25,32 @@ std::pair<Lit, Lit> make_pair(Lit a, Lit b)
 	return a < b ? std::pair(a, b) : std::pair(b, a);
 }
 
+struct VivifyStats
+{
+	int64_t shortened = 0;    // number of lits removed
+	int64_t strengthened = 0; // number of lits replaced by stronger one
+	int64_t nTernStrengthened = 0;
+	int64_t nHitsOld = 0, nHitsNew = 0;
+	int64_t nOld = 0, nNew = 0;
+
+	VivifyStats &operator+=(VivifyStats const &b)
+	{
+		shortened += b.shortened;
+		strengthened += b.strengthened;
+		nTernStrengthened += b.nTernStrengthened;
+		nHitsOld += b.nHitsOld;
+		nHitsNew += b.nHitsNew;
+		nOld += b.nOld;
+		nNew += b.nNew;
+		return *this;
+	}
+};
+
 struct Vivification
 {
 	Cnf &cnf_;
 	PropEngineLight p;
-	int64_t shortened = 0;    // number of lits removed
-	int64_t strengthened = 0; // number of lits replaced by stronger one
+	VivifyStats stats;
 
 	util::hash_map<std::pair<Lit, Lit>, util::small_vector<Lit, 1>> ternaries;
 
@@ -68,12 +90,12 @@ struct Vivification
 
 			if (p.conflict)
 			{
-				shortened += 1;
+				stats.shortened += 1;
 				std::swap(cl[i], cl.back());
 				cl.pop_back();
 				--i;
 				p.unroll();
-				shortened += 1;
+				stats.shortened += 1;
 				change = true;
 				continue;
 			}
@@ -95,7 +117,7 @@ struct Vivification
 					if (p.probe(a) == -1)
 					{
 						cl[i] = a.neg();
-						strengthened += 1;
+						stats.strengthened += 1;
 						change = true;
 
 						goto again;
@@ -112,7 +134,7 @@ struct Vivification
 			p.propagate(cl[i].neg());
 			if (p.conflict)
 			{
-				shortened += cl.size() - (i + 1);
+				stats.shortened += cl.size() - (i + 1);
 				cl.resize(i + 1);
 				change = true;
 				break;
@@ -172,8 +194,116 @@ struct Vivification
 				}
 		return false;
 	}
+
+	// Try to vivify a long clause (which belongs to 'cnf_').
+	//   - on success, the strengthened clause is added to 'out' and 'cl' is
+	//     re-colored black (and thus ignored by further propagation)
+	//   - otherwise, 'cl' counts as "fully vivified" and is flagged as such
+	//   - returns true on success
+	bool process(Clause &cl, VivifyConfig const &config, std::vector<Lit> &buf,
+	             ClauseStorage &out)
+	{
+		if (cl.has_flag(Flag::vivified))
+			stats.nOld += 1;
+		else
+			stats.nNew += 1;
+		buf.assign(cl.begin(), cl.end());
+
+		bool hit = false;
+		if (vivify_clause(buf, config.with_binary))
+		{
+			assert(buf.size() <= cl.size());
+			hit = true;
+		}
+		// TODO: get rid of the "size >= 4" condition. Tern-Strengthening
+		// terneries would be great. Just be careful to not strengthen a clause
+		// with itself.
+		else if (config.with_ternary && buf.size() >= 4 &&
+		         vivify_clause_ternary(buf))
+		{
+			stats.nTernStrengthened += 1;
+			hit = true;
+		}
+
+		if (!hit)
+		{
+			// nothing changed, 'cl' counts as "fully vivified"
+			cl.set_flag(Flag::vivified);
+			return false;
+		}
+
+		out.add_clause(buf, cl.color());
+		cnf_.proof_add(buf);
+		cnf_.proof_delete(cl.lits());
+		cl.set_color(Color::black);
+		if (cl.has_flag(Flag::vivified))
+			stats.nHitsOld += 1;
+		else
+			stats.nHitsNew += 1;
+		return true;
+	}
 };
 
+// Vivify the clauses 'todo' in parallel. Each thread works on a contiguous
+// batch, using its own copy of the formula (and thus its own PropEngineLight).
+// Results are merged in batch order, i.e., the same as in a serial run.
+VivifyStats vivify_parallel(Cnf &cnf, std::span<const CRef> todo,
+                            VivifyConfig const &config, int threads,
+                            ClauseStorage &new_clauses, std::stop_token stoken)
+{
+	struct Batch
+	{
+		ClauseStorage new_clauses;
+		std::vector<CRef> hits, misses;
+		VivifyStats stats;
+	};
+	auto batches = std::vector<Batch>(threads);
+
+	run_parallel(threads, [&](int t) {
+		auto [lo, hi] = split_range(todo.size(), threads, t);
+		auto &batch = batches[t];
+
+		auto local = Cnf(cnf.var_count());
+		local.units = cnf.units;
+		local.bins = cnf.bins;
+		local.clauses = cnf.clauses;
+		auto viv = Vivification(local, config);
+
+		std::vector<Lit> buf;
+		for (size_t k = lo; k < hi; ++k)
+		{
+			if (stoken.stop_requested())
+				break;
+			if (viv.process(local.clauses[todo[k]], config, buf,
+			                batch.new_clauses))
+				batch.hits.push_back(todo[k]);
+			else
+				batch.misses.push_back(todo[k]);
+		}
+		batch.stats = viv.stats;
+	});
+
+	// apply results to the original formula
+	VivifyStats stats;
+	for (auto &batch : batches)
+	{
+		for (auto &cl : batch.new_clauses.all())
+		{
+			cnf.proof_add(cl.lits());
+			new_clauses.add_clause(cl.lits(), cl.color());
+		}
+		for (CRef i : batch.hits)
+		{
+			cnf.proof_delete(cnf.clauses[i].lits());
+			cnf.clauses[i].set_color(Color::black);
+		}
+		for (CRef i : batch.misses)
+			cnf.clauses[i].set_flag(Flag::vivified);
+		stats += batch.stats;
+	}
+	return stats;
+}
+
 } // namespace
 
 bool run_vivification(Cnf &cnf, VivifyConfig const &config,
@@ -191,9 +321,6 @@ bool run_vivification(Cnf &cnf, VivifyConfig const &config,
 	// clauses, and rely on a later TBR run to clean up.
 	std::vector<Lit> buf;
 	ClauseStorage new_clauses;
-	int nTernStrengthened = 0;
-	int nHitsOld = 0, nHitsNew = 0;
-	int nOld = 0, nNew = 0;
 
 	// shortening binaries is essentially probing, which is done elsewhere.
 	// but strengthening binaries along other binaries is kinda cool and we do
@@ -207,57 +334,38 @@ bool run_vivification(Cnf &cnf, VivifyConfig const &config,
 					continue;
 				buf = {a, b};
 				if (viv.vivify_clause(buf, true))
+				{
+					cnf.proof_add(buf);
 					new_clauses.add_clause(buf, Color::blue);
+				}
 			}
 	}
 
-	for (auto &cl : cnf.clauses.all())
+	// As can be seen by the "old" vs "new" statistics, vivifying fresh
+	// learnt clauses (both from CDCL and from resolution/BVE) is quite
+	// effective, but trying old ones again rarely results in anything.
+	std::vector<CRef> todo;
+	for (auto [ci, cl] : cnf.clauses.enumerate())
+		if (cl.color() > Color::red &&
+		    !(config.only_new && cl.has_flag(Flag::vivified)))
+			todo.push_back(ci);
+
+	// copying the whole formula for each thread only pays off for reasonably
+	// large batches
+	int threads = effective_threads(config.threads, todo.size() / 1000);
+	auto stats = viv.stats;
+	if (threads > 1)
+		stats += vivify_parallel(cnf, todo, config, threads, new_clauses,
+		                         stoken);
+	else
 	{
-		if (cl.color() <= Color::red)
-			continue;
-		if (stoken.stop_requested())
-			break;
-
-		// As can be seen by the "old" vs "new" statistics, vivifying fresh
-		// learnt clauses (both from CDCL and from resolution/BVE) is quite
-		// effective, but trying old ones again rarely results in anything.
-		if (config.only_new && cl.has_flag(Flag::vivified))
-			continue;
-
-		if (cl.has_flag(Flag::vivified))
-			nOld += 1;
-		else
-			nNew += 1;
-		buf.assign(cl.begin(), cl.end());
-		if (viv.vivify_clause(buf, config.with_binary))
+		for (CRef i : todo)
 		{
-			assert(buf.size() <= cl.size());
-			new_clauses.add_clause(buf, cl.color());
-			cl.set_color(Color::black);
-			if (cl.has_flag(Flag::vivified))
-				nHitsOld += 1;
-			else
-				nHitsNew += 1;
-		}
-		// TODO: get rid of the "size >= 4" condition. Tern-Strengthening
-		// terneries would be great. Just be careful to not strengthen a clause
-		// with itself.
-		else if (config.with_ternary && buf.size() >= 4 &&
-		         viv.vivify_clause_ternary(buf))
-		{
-			nTernStrengthened += 1;
-			new_clauses.add_clause(buf, cl.color());
-			cl.set_color(Color::black);
-			if (cl.has_flag(Flag::vivified))
-				nHitsOld += 1;
-			else
-				nHitsNew += 1;
-		}
-		else
-		{
-			// nothing changed, 'cl' counts as "fully vivified"
-			cl.set_flag(Flag::vivified);
+			if (stoken.stop_requested())
+				break;
+			viv.process(cnf.clauses[i], config, buf, new_clauses);
 		}
+		stats = viv.stats;
 	}
 
 	if (new_clauses.empty())
@@ -266,17 +374,21 @@ bool run_vivification(Cnf &cnf, VivifyConfig const &config,
 		return false;
 	}
 
+	// new clauses were already written to the proof when they were found
 	cnf.clauses.prune_black();
+	auto proof = std::exchange(cnf.proof, nullptr);
 	for (auto &cl : new_clauses.all())
 		cnf.add_clause(cl.lits(), cl.color());
+	cnf.proof = proof;
 
 	log.info("removed {} lits, and bin-replaced {}, tern-replaced {}",
-	         viv.shortened, viv.strengthened, nTernStrengthened);
+	         stats.shortened, stats.strengthened, stats.nTernStrengthened);
 	log.info("processed {} old clauses ({:.2f}%% hit rate) and {} new clauses "
 	         "({:.2f}%% hit rate)",
-	         nOld, 100. * nHitsOld / nOld, nNew, 100. * nHitsNew / nNew);
+	         stats.nOld, 100. * stats.nHitsOld / stats.nOld, stats.nNew,
+	         100. * stats.nHitsNew / stats.nNew);
 
-	return viv.shortened + viv.strengthened;
+	return stats.shortened + stats.strengthened;
 }
 
 } // namespace dawn
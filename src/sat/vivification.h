@@ -18,6 +18,11 @@ struct VivifyConfig
 	// only vivify clauses without the '.vivified' flag, i.e., only those that
 	// have not been vivified before.
 	bool only_new = false;
+
+	// Number of threads (<= 0 means all cores). Long clauses are split into
+	// disjoint batches, each vivified on a private copy of the formula. The
+	// strengthened clauses are merged afterwards in batch order.
+	int threads = 1;
 };
 
 // run vivification
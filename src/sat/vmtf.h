@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace dawn {
+
+/**
+ * Variable-move-to-front queue. Alternative to the ActivityHeap with the same
+ * interface (as far as the PropEngine is concerned), but O(1) per bump.
+ *   * variables are kept in a doubly linked list, ordered by the time of their
+ *     last bump (i.e., 'stamp')
+ *   * bumps are collected during conflict analysis and applied in
+ *     'decay_variable_activity', in order of their previous stamps, which
+ *     keeps the relative order of the bumped variables intact
+ *   * a search cursor points to the most recent variable that might be
+ *     unassigned. Everything more recent is known to be assigned.
+ */
+class VmtfQueue
+{
+	struct Link
+	{
+		int prev = -1, next = -1; // towards older/more recent variables
+	};
+
+	std::vector<Link> links_;
+	std::vector<int64_t> stamp_;
+	int64_t stamp_counter_ = 0;
+	int oldest_ = -1, newest_ = -1;
+	int search_ = -1;          // search cursor
+	std::vector<int> pending_; // bumped during current conflict analysis
+
+	void unlink(int var)
+	{
+		auto [prev, next] = links_[var];
+		(prev == -1 ? oldest_ : links_[prev].next) = next;
+		(next == -1 ? newest_ : links_[next].prev) = prev;
+	}
+
+	void append(int var)
+	{
+		links_[var] = {newest_, -1};
+		(newest_ == -1 ? oldest_ : links_[newest_].next) = var;
+		newest_ = var;
+		stamp_[var] = ++stamp_counter_;
+	}
+
+  public:
+	// initial order: variable 0 first
+	explicit VmtfQueue(int var_count) : links_(var_count), stamp_(var_count)
+	{
+		for (int i = var_count - 1; i >= 0; --i)
+			append(i);
+		search_ = newest_;
+	}
+
+	// variable became unassigned
+	void push(int var)
+	{
+		if (search_ == -1 || stamp_[var] > stamp_[search_])
+			search_ = var;
+	}
+
+	// mark variable for moving to the front (must be assigned)
+	void bump_variable_activity(int var) { pending_.push_back(var); }
+
+	// move all variables bumped since the last call to the front
+	void decay_variable_activity()
+	{
+		std::sort(pending_.begin(), pending_.end(),
+		          [&](int a, int b) { return stamp_[a] < stamp_[b]; });
+		for (int var : pending_)
+		{
+			if (var == newest_)
+			{
+				stamp_[var] = ++stamp_counter_;
+				continue;
+			}
+			if (var == search_)
+				search_ = links_[var].prev;
+			unlink(var);
+			append(var);
+		}
+		pending_.clear();
+	}
+
+	// forget the search cursor (needed if 'push' was not called for every
+	// unassigned variable)
+	void reset_search() { search_ = newest_; }
+
+	// most recently bumped variable satisfying 'unassigned(var)', or -1 if
+	// there is none. Moves the search cursor accordingly.
+	template <class F> int next(F &&unassigned)
+	{
+		while (search_ != -1 && !unassigned(search_))
+			search_ = links_[search_].prev;
+		return search_;
+	}
+};
+
+} // namespace dawn
@@ -1,13 +1,52 @@
+#include "catch2/benchmark/catch_benchmark.hpp"
 #include "catch2/catch_test_macros.hpp"
 
+#include "ipasir/ipasir.h"
+#include "sat/activity_heap.h"
+#include "sat/approxmc.h"
+#include "sat/binary_cnf.h"
+#include "sat/clause_export.h"
 #include "sat/cnf.h"
+#include "sat/dimacs.h"
 #include "sat/elimination.h"
+#include "sat/incremental.h"
+#include "sat/proof_check.h"
+#include "sat/sls.h"
 
 #include "fmt/format.h"
 #include "fmt/ostream.h"
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <set>
 
 using namespace dawn;
 
+namespace {
+// write 'content' to a file in the temp directory, returning its path
+std::string temp_file(std::string const &name, std::string_view content) {
+  auto path = (std::filesystem::temp_directory_path() /
+               fmt::format("dawn_test_{}", name))
+                  .string();
+  std::ofstream(path, std::ios::binary) << content;
+  return path;
+}
+
+// (non-removed) clauses in DIMACS numbering, for easy comparison
+std::vector<std::vector<int>> dump(ClauseStorage const &clauses) {
+  std::vector<std::vector<int>> r;
+  for (auto const &cl : clauses.all()) {
+    r.emplace_back();
+    for (Lit a : cl.lits())
+      r.back().push_back(a.toDimacs());
+  }
+  return r;
+}
+} // namespace
+
 TEST_CASE("parser and clause normalization") {
   Cnf sat(5);
   sat.add_clause_safe("1 -1");
@@ -23,6 +62,74 @@ TEST_CASE("parser and clause normalization") {
 )");
 }
 
+TEST_CASE("parallel DIMACS parsing") {
+  // clauses spanning lines, comments ending in '0', header at the end
+  std::string content = R"(c comment ending in 0
+1 -2
+ 3 0
+c another one 10
+-1 2 0
+4
+-3
+0
+2 3 4 0
+c p cnf 9 9 is not a header
+-4 0
+p cnf 4 5
+)";
+  auto [seq, seq_vars] = parseCnfFromString(content, 1);
+  CHECK(seq_vars == 4);
+  CHECK(dump(seq) == std::vector<std::vector<int>>{
+                         {1, -2, 3}, {-1, 2}, {4, -3}, {2, 3, 4}, {-4}});
+  for (int threads : {2, 3, 8}) {
+    auto [par, par_vars] = parseCnfFromString(content, threads, 1);
+    CHECK(par_vars == seq_vars);
+    CHECK(dump(par) == dump(seq));
+  }
+  CHECK_THROWS(parseCnfFromString("p cnf 2 2\n1 2 0\n", 4, 1));
+}
+
+TEST_CASE("binary CNF round trip") {
+  Cnf sat(6);
+  sat.add_clause_safe("1");
+  sat.add_clause_safe("-2");
+  sat.add_clause_safe("1 3");
+  sat.add_clause_safe("-3 4");
+  sat.add_clause_safe("2 4 5");
+  sat.add_clause_safe("1 -4 -5 6");
+  sat.reconstruction().add_rule(std::array{Lit(5, false), Lit(3, true)});
+  auto file = (std::filesystem::temp_directory_path() / "dawn_test.dawncnf")
+                  .string();
+  write_binary_cnf(file, sat, true);
+
+  auto info = peek_binary_cnf(file);
+  REQUIRE(info);
+  CHECK(info->var_count == 6);
+  CHECK(info->has_reconstruction);
+
+  Cnf r;
+  read_binary_cnf(file, r);
+  CHECK(r.var_count() == sat.var_count());
+  CHECK(r.contradiction == sat.contradiction);
+  CHECK(r.units == sat.units);
+  for (Lit a : sat.all_lits())
+    CHECK(std::ranges::equal(r.bins[a], sat.bins[a]));
+  CHECK(dump(r.clauses) == dump(sat.clauses));
+  CHECK(r.reconstruction().serialize() == sat.reconstruction().serialize());
+
+  // DIMACS is not binary, truncated files are rejected
+  CHECK(!peek_binary_cnf(temp_file("plain.cnf", "p cnf 1 1\n1 0\n")));
+  std::ifstream in(file, std::ios::binary);
+  auto content = std::string(std::istreambuf_iterator<char>(in), {});
+  auto truncated = temp_file(
+      "truncated.dawncnf",
+      std::string_view(content).substr(0, content.size() - 4));
+  CHECK_THROWS(peek_binary_cnf(truncated));
+  CHECK_THROWS(read_binary_cnf(truncated, r));
+  CHECK_THROWS(peek_binary_cnf(
+      temp_file("header.dawncnf", std::string_view(content).substr(0, 20))));
+}
+
 TEST_CASE("bounded variable elimination", "[BVE]") {
   Cnf sat(5);
   sat.add_clause_safe("1 2 3");
@@ -32,3 +139,357 @@ TEST_CASE("bounded variable elimination", "[BVE]") {
   run_elimination(sat, {});
   // fmt::print("{}", sat);
 }
+
+TEST_CASE("activity heap order") {
+  auto check = [](auto heap, int n) {
+    heap.set_decay(1.0);
+    for (int i = 0; i < n; ++i)
+      for (int k = 0; k < i; ++k)
+        heap.bump_variable_activity(i);
+    for (int i = n - 1; i >= 0; --i)
+      CHECK(heap.pop() == i);
+    CHECK(heap.empty());
+  };
+  check(BasicActivityHeap<2, double>(100), 100);
+  check(BasicActivityHeap<4, float>(100), 100);
+}
+
+TEST_CASE("local search on planted 3-SAT") {
+  // random clauses satisfied by a hidden assignment
+  std::mt19937 rng(0);
+  int n = 200;
+  std::vector<bool> planted(n);
+  for (int i = 0; i < n; ++i)
+    planted[i] = rng() & 1;
+  Cnf sat(n);
+  for (int k = 0; k < 4 * n; ++k) {
+    std::vector<Lit> cl;
+    for (int j = 0; j < 3; ++j)
+      cl.push_back(Lit((int)(rng() % n), rng() & 1));
+    if (!std::ranges::any_of(
+            cl, [&](Lit a) { return planted[a.var()] != a.sign(); }))
+      cl[0] = cl[0].neg();
+    sat.add_clause_safe(cl);
+  }
+
+  auto sls = Sls(sat);
+  auto rng2 = util::xoshiro256(0);
+  REQUIRE(sls.run(Assignment(n), 1'000'000, rng2));
+  CHECK(sls.best_unsat() == 0);
+  CHECK(sls.best().satisfied(sat.clauses));
+}
+
+TEST_CASE("incremental solving with assumptions") {
+  // implication chain x0 -> x1 -> ... -> x9, only the ends are frozen
+  IncrementalSolver solver;
+  int n = 10;
+  for (int i = 0; i < n; ++i)
+    solver.add_var();
+  for (int i = 0; i + 1 < n; ++i)
+    solver.add_clause(std::array{Lit(i, true), Lit(i + 1, false)});
+  solver.freeze(0);
+  solver.freeze(n - 1);
+
+  solver.assume(Lit(0, false));
+  solver.assume(Lit(n - 1, true));
+  REQUIRE(solver.solve() == 20);
+  CHECK(solver.failed(Lit(0, false)));
+  CHECK(solver.failed(Lit(n - 1, true)));
+
+  // assumptions are gone, middle of the chain was eliminated
+  REQUIRE(solver.solve() == 10);
+  CHECK_THROWS(solver.add_clause(std::array{Lit(n / 2, false)}));
+
+  solver.add_clause(std::array{Lit(n - 1, true)});
+  int y = solver.add_var();
+  solver.add_clause(std::array{Lit(0, false), Lit(y, false)});
+  REQUIRE(solver.solve() == 10);
+  CHECK(solver.value(Lit(0, false)) == lfalse);
+  CHECK(solver.value(Lit(y, false)) == ltrue);
+}
+
+TEST_CASE("IPASIR interface") {
+  // 'n' pigeons in 'n-1' holes, variables 1,...,n*(n-1)
+  auto pigeonhole = [](void *s, int n) {
+    auto p = [n](int i, int j) { return i * (n - 1) + j + 1; };
+    for (int i = 0; i < n; ++i) {
+      for (int j = 0; j < n - 1; ++j)
+        ipasir_add(s, p(i, j));
+      ipasir_add(s, 0);
+    }
+    for (int j = 0; j < n - 1; ++j)
+      for (int i = 0; i < n; ++i)
+        for (int k = i + 1; k < n; ++k) {
+          ipasir_add(s, -p(i, j));
+          ipasir_add(s, -p(k, j));
+          ipasir_add(s, 0);
+        }
+  };
+
+  // (1 or 2) and (-1 or 2) and (-2 or 3 or 4)
+  void *s = ipasir_init();
+  for (int lit : {1, 2, 0, -1, 2, 0, -2, 3, 4, 0})
+    ipasir_add(s, lit);
+  REQUIRE(ipasir_solve(s) == 10);
+  CHECK(ipasir_val(s, 2) == 2);
+  CHECK(ipasir_val(s, -2) == 2);
+  ipasir_assume(s, -3);
+  ipasir_assume(s, -4);
+  REQUIRE(ipasir_solve(s) == 20);
+  CHECK(ipasir_failed(s, -3));
+  CHECK(ipasir_failed(s, -4));
+  ipasir_assume(s, -3);
+  REQUIRE(ipasir_solve(s) == 10);
+  CHECK(ipasir_val(s, 4) == 4);
+  ipasir_release(s);
+
+  // learnt clauses, zero-terminated and within the size limit
+  s = ipasir_init();
+  pigeonhole(s, 6);
+  std::vector<std::vector<int32_t>> learnt;
+  ipasir_set_learn(s, &learnt, 16, [](void *data, int32_t *cl) {
+    auto &v = *static_cast<std::vector<std::vector<int32_t>> *>(data);
+    v.emplace_back();
+    for (; *cl; ++cl)
+      v.back().push_back(*cl);
+  });
+  REQUIRE(ipasir_solve(s) == 20);
+  CHECK(!learnt.empty());
+  for (auto const &cl : learnt) {
+    CHECK(cl.size() <= 16);
+    for (int32_t x : cl)
+      CHECK((x != 0 && std::abs(x) <= 30));
+  }
+  ipasir_release(s);
+
+  // interrupted right away
+  s = ipasir_init();
+  pigeonhole(s, 9);
+  int calls = 0;
+  ipasir_set_terminate(s, &calls, [](void *data) {
+    *static_cast<int *>(data) += 1;
+    return 1;
+  });
+  CHECK(ipasir_solve(s) == 0);
+  CHECK(calls > 0);
+  ipasir_release(s);
+}
+
+TEST_CASE("model enumeration with projection") {
+  // (x0 or x1 or x2) and (x0 or y)
+  auto make = [](IncrementalSolver &solver) {
+    for (int i = 0; i < 4; ++i)
+      solver.add_var();
+    solver.add_clause(std::array{Lit(0, false), Lit(1, false), Lit(2, false)});
+    solver.add_clause(std::array{Lit(0, false), Lit(3, false)});
+  };
+
+  IncrementalSolver all;
+  make(all);
+  int count = 0;
+  auto f_all = [&] {
+    count += 1;
+    return true;
+  };
+  CHECK(all.enumerate({}, f_all) == 20);
+  CHECK(count == 11);
+
+  // stop after two solutions, then continue with the rest
+  IncrementalSolver projected;
+  make(projected);
+  std::set<int> seen;
+  auto proj = std::array{0, 1, 2};
+  auto f = [&] {
+    int x = 0;
+    for (int i = 0; i < 3; ++i)
+      x |= (projected.value(Lit(i, false)) == ltrue) << i;
+    seen.insert(x);
+    return seen.size() != 2;
+  };
+  CHECK(projected.enumerate(proj, f) == 30);
+  CHECK(projected.enumerate(proj, f) == 20);
+  CHECK(seen.size() == 7);
+  CHECK(!seen.contains(0));
+
+  // a locked variable in the projection is rejected before freezing the
+  // others, so x0 is still frozen exactly once
+  IncrementalSolver locked;
+  make(locked);
+  locked.freeze(0);
+  REQUIRE(locked.solve() == 10);
+  locked.assume(Lit(0, false));
+  CHECK_THROWS(locked.enumerate(std::array{0, 1}, [] { return true; }));
+  locked.melt(0);
+  CHECK_THROWS(locked.melt(0));
+}
+
+TEST_CASE("xor constraints and approximate counting") {
+  // x0 ^ -x1 ^ x2 ^ x3 = 0, i.e., odd parity. One solution for each
+  // assignment of x1..x3.
+  IncrementalSolver solver;
+  for (int i = 0; i < 4; ++i)
+    solver.add_var();
+  auto lits = std::array{Lit(0, false), Lit(1, true), Lit(2, false),
+                         Lit(3, false)};
+  solver.add_xor(lits, false);
+  int count = 0;
+  CHECK(solver.enumerate({}, [&] {
+    bool parity = false;
+    for (int i = 0; i < 4; ++i)
+      parity ^= solver.value(Lit(i, false)) == ltrue;
+    CHECK(parity);
+    count += 1;
+    return true;
+  }) == 20);
+  CHECK(count == 8);
+
+  // 3 * 2^17 solutions when projected onto the first 19 variables, too many
+  // for an exact count. The estimate should be within the tolerance.
+  Cnf sat(21);
+  sat.add_clause_safe("1 2");
+  auto proj = std::vector<int>();
+  for (int i = 0; i < 19; ++i)
+    proj.push_back(i);
+  auto c = approx_count(std::move(sat), proj, {}, {});
+  REQUIRE(c);
+  CHECK(!c->exact);
+  double estimate = std::stod(c->to_string());
+  CHECK(estimate >= 3 * (1 << 17) / 1.8);
+  CHECK(estimate <= 3 * (1 << 17) * 1.8);
+  auto big = ApproxCount{.cell_count = 5, .hash_count = 70};
+  CHECK(big.to_string() == "5902958103587056517120");
+}
+
+TEST_CASE("clause export drop policy") {
+  for (auto policy :
+       {ClauseExport::DropPolicy::newest, ClauseExport::DropPolicy::oldest}) {
+    // the first clause blocks the consumer, so the queue fills up
+    std::atomic<bool> entered = false, release = false;
+    std::vector<int> got;
+    auto e = ClauseExport({.capacity = 2, .drop = policy}, [&](auto cl) {
+      entered = true;
+      while (!release)
+        std::this_thread::yield();
+      got.push_back(cl[0].var());
+    });
+    e.push(std::array{Lit(0, false)});
+    while (!entered)
+      std::this_thread::yield();
+    CHECK(e.push(std::array{Lit(1, false)}));
+    CHECK(e.push(std::array{Lit(2, false)}));
+    CHECK(e.push(std::array{Lit(3, false)}) ==
+          (policy == ClauseExport::DropPolicy::oldest));
+    release = true;
+    e.flush();
+    CHECK(e.dropped() == 1);
+    auto want = policy == ClauseExport::DropPolicy::newest
+                    ? std::vector<int>{0, 1, 2}
+                    : std::vector<int>{0, 2, 3};
+    CHECK(got == want);
+  }
+}
+
+TEST_CASE("DRAT proof with a RAT step") {
+  // drat-trim's example (variables shifted by one) plus '-1 -2'. The first
+  // lemma is RAT on -2, but not on 1, which sorts first.
+  auto cnf = parseCnf(temp_file("rat.cnf", R"(p cnf 5 9
+2 3 -4 0
+-2 -3 4 0
+3 4 -5 0
+-3 -4 5 0
+2 4 5 0
+-2 -4 -5 0
+-2 3 5 0
+2 -3 -5 0
+-1 -2 0
+)"))
+                 .first;
+  auto r = check_drat_proof(
+      cnf, temp_file("rat.drat", "-2 1 0\n-2 0\n3 0\n0\n"));
+  CHECK(r.valid);
+  CHECK(r.rat == 1);
+
+  // the same lemma is not RAT when written with the other pivot
+  r = check_drat_proof(
+      cnf, temp_file("rat2.drat", "1 -2 0\n-2 0\n3 0\n0\n"));
+  CHECK(!r.valid);
+}
+
+TEST_CASE("LRAT proof checking") {
+  auto cnf = parseCnf(temp_file("lrat.cnf", "p cnf 2 4\n1 2 0\n-1 2 0\n"
+                                            "1 -2 0\n-1 -2 0\n"))
+                 .first;
+  auto r = check_lrat_proof(
+      cnf, temp_file("good.lrat", "5 2 0 1 2 0\n5 d 1 2 0\n6 0 5 3 4 0\n"));
+  CHECK(r.valid);
+  CHECK(r.deletions == 2);
+
+  // the hint for clause 4 is missing, so there is no conflict
+  r = check_lrat_proof(cnf,
+                       temp_file("bad.lrat", "5 2 0 1 2 0\n6 0 5 3 0\n"));
+  CHECK(!r.valid);
+  CHECK(r.message == "lemma 6: no conflict");
+}
+
+namespace {
+// Trace of heap operations resembling CDCL search: each conflict bumps a
+// few dozen variables (mostly ones involved in recent conflicts), followed
+// by re-inserting the previously decided variables and some new decisions.
+struct HeapTrace {
+  struct Conflict {
+    std::vector<int> bumps;
+    int decisions;
+  };
+  int var_count;
+  std::vector<Conflict> conflicts;
+
+  HeapTrace(int n, int confls) : var_count(n) {
+    auto rng = std::mt19937(0);
+    std::vector<int> recent;
+    for (int c = 0; c < confls; ++c) {
+      Conflict k;
+      int len = 20 + rng() % 100;
+      for (int i = 0; i < len; ++i)
+        k.bumps.push_back(!recent.empty() && rng() % 4
+                              ? recent[rng() % recent.size()]
+                              : (int)(rng() % n));
+      std::sort(k.bumps.begin(), k.bumps.end());
+      k.bumps.erase(std::unique(k.bumps.begin(), k.bumps.end()),
+                    k.bumps.end());
+      recent = k.bumps;
+      k.decisions = 1 + rng() % 30;
+      conflicts.push_back(std::move(k));
+    }
+  }
+
+  template <class Heap> int64_t replay() const {
+    auto heap = Heap(var_count);
+    int64_t sum = 0;
+    std::vector<int> decided;
+    for (auto const &c : conflicts) {
+      for (int v : c.bumps)
+        heap.bump_variable_activity(v);
+      heap.decay_variable_activity();
+      for (int v : decided)
+        heap.push(v);
+      decided.clear();
+      for (int i = 0; i < c.decisions && !heap.empty(); ++i) {
+        decided.push_back(heap.pop());
+        sum += decided.back();
+      }
+    }
+    return sum;
+  }
+};
+} // namespace
+
+// run with 'dawn test "[benchmark]"'
+TEST_CASE("activity heap throughput", "[.][benchmark]") {
+  auto trace = HeapTrace(100'000, 100'000);
+  BENCHMARK("binary heap, double") {
+    return trace.replay<BasicActivityHeap<2, double>>();
+  };
+  BENCHMARK("4-ary heap, float") {
+    return trace.replay<BasicActivityHeap<4, float>>();
+  };
+}